@@ -0,0 +1,285 @@
+#include "qthdf5.h"
+#include "qh5pyramid.h"
+#include "qh5chunkstats.h"
+#include "qh5reduce.h"
+
+#include <hdf5.h>
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+/*! \example examples/benchmark/main.cpp
+ *
+ * Micro-benchmarks of the QtHDF5 per-call overhead.
+ *
+ * Many small objects (attributes, scalar datasets, groups) are written to an
+ * in-memory HDF5 file, so that the cost of the wrappers and of the
+ * HDF5 handles they create is measured rather than disk I/O.
+ *
+ * The datatype benchmark compares the shared datatypes returned by
+ * QH5Datatype::fromValue() with a fresh copy per call (H5Tcopy),
+ * which was the behavior of earlier versions.
+ *
+ * The handle benchmarks show the cost of copying a wrapper (H5Iinc_ref and
+ * close) compared to moving it, which does not call HDF5.
+ *
+ * Every case also reports the HDF5 handle churn: the datatype, dataspace
+ * and property list ids created per call, and the number of open file
+ * objects (H5Fget_obj_count) before and after the case.
+ *
+ * The catalog benchmark lists a tree of groups and datasets by a
+ * recursive descent, opening each group, and by a single QH5Group::visit().
+ *
+ * The path lookup benchmark opens the same dataset by chained
+ * openGroup()/openDataset() calls and by QH5File::dataset(), which keeps
+ * the handle in a cache.
+ *
+ * The pyramid benchmark reads a zoomed-out view of a 10M sample trace,
+ * 2000 pixels wide, from the raw samples and with QH5Pyramid::readDecimated().
+ *
+ * The threshold scan counts the samples above a threshold in a quiet
+ * signal with a few spikes, reading all samples and only the chunks selected
+ * by QH5ChunkStats.
+ *
+ * The reduction benchmark computes the sum, minimum and maximum of a
+ * compressed float dataset, reading it into memory and looping, and with
+ * QH5Reduce.
+ *
+ */
+
+// count the objects below g by opening every sub-group
+int descend(const QH5Group& g)
+{
+    int n = g.datasetNames().size();
+    foreach(const QH5Group& s, g.subGroups()) n += 1 + descend(s);
+    return n;
+}
+
+/*
+ * Counters of HDF5 ids
+ *
+ * HDF5 numbers the ids of each type sequentially, in the bits below the type
+ * bits, so the ids created in between are counted by creating a probe id
+ * before and after.
+ */
+struct IdCount
+{
+    enum { TYPE, SPACE, PLIST, N };
+    qint64 serial[N];   // serial of a probe id
+    qint64 open;        // open files, groups, datasets, attributes and named datatypes
+
+    static qint64 serialOf(hid_t id)
+    {
+        return qint64(id) & ((qint64(1) << (sizeof(hid_t)*8 - 8)) - 1);
+    }
+
+    static IdCount now()
+    {
+        IdCount c;
+        hid_t t = H5Tcopy(H5T_NATIVE_INT);
+        hid_t s = H5Screate(H5S_SCALAR);
+        hid_t p = H5Pcreate(H5P_DATASET_XFER);
+        c.serial[TYPE] = serialOf(t);
+        c.serial[SPACE] = serialOf(s);
+        c.serial[PLIST] = serialOf(p);
+        H5Tclose(t);
+        H5Sclose(s);
+        H5Pclose(p);
+
+        c.open = H5Fget_obj_count(H5F_OBJ_ALL, H5F_OBJ_ALL);
+        return c;
+    }
+};
+
+// run f n times and print the time and the ids created per call
+template<typename F>
+void bench(const char* name, int n, F f)
+{
+    IdCount c0 = IdCount::now();
+    QElapsedTimer t;
+    t.start();
+    for(int i=0; i<n; ++i) f(i);
+    qint64 dt = t.nsecsElapsed();
+    IdCount c1 = IdCount::now();
+
+    // minus the probe id
+    double ids[IdCount::N];
+    for(int k=0; k<IdCount::N; ++k)
+        ids[k] = double(c1.serial[k] - c0.serial[k] - 1)/n;
+
+    qDebug().noquote() << QString("%1 %2 calls %3 ms %4 ns/call, ids/call: %5 type %6 space %7 plist, open objects %8 -> %9")
+                          .arg(name, -32).arg(n).arg(dt/1000000)
+                          .arg(double(dt)/n, 0, 'f', 0)
+                          .arg(ids[IdCount::TYPE], 0, 'f', 2)
+                          .arg(ids[IdCount::SPACE], 0, 'f', 2)
+                          .arg(ids[IdCount::PLIST], 0, 'f', 2)
+                          .arg(c0.open).arg(c1.open);
+}
+
+int main()
+{
+    const int N = 100000;
+
+    try {
+
+    QH5File h5f("benchmark.h5");
+    h5f.setInMemory(true);
+    if (!h5f.open(QIODevice::Truncate)) {
+        qDebug() << "Cannot create in-memory file";
+        return -1;
+    }
+    QH5Group root = h5f.root();
+
+    bench("datatype, shared", 10*N, [](int i) {
+        QH5Datatype t = QH5Datatype::fromValue(double(i));
+    });
+    bench("datatype, H5Tcopy", 10*N, [](int i) {
+        QH5Datatype t = QH5Datatype::fromValue(double(i)).copy();
+    });
+
+    // per-handle overhead of the wrappers
+    QH5Group h = root.createGroup("handles");
+    bench("QH5Group copy + destroy", 10*N, [&h](int) {
+        QH5Group c(h);
+    });
+    bench("QH5Group move + destroy", 10*N, [&h](int) {
+        QH5Group c(std::move(h));
+        h = std::move(c);
+    });
+    bench("QH5Group::isValid()", 10*N, [&h](int) {
+        volatile bool b = h.isValid();
+        Q_UNUSED(b)
+    });
+    bench("QH5Group::isNull()", 10*N, [&h](int) {
+        volatile bool b = h.isNull();
+        Q_UNUSED(b)
+    });
+
+    // 100 attributes per group, as the object header is searched for each one
+    QH5Group g = root.createGroup("attributes");
+    QVector<QH5Group> groups;
+    for(int i=0; i<N/100; ++i)
+        groups.push_back(g.createGroup(QByteArray("g") + QByteArray::number(i)));
+    bench("writeAttribute(int)", N, [&groups](int i) {
+        groups[i/100].writeAttribute(QByteArray("a") + QByteArray::number(i%100), i);
+    });
+    bench("readAttribute(int)", N, [&groups](int i) {
+        int v;
+        groups[i/100].readAttribute(QByteArray("a") + QByteArray::number(i%100), v);
+    });
+
+    g = root.createGroup("datasets");
+    bench("write(double) scalar dataset", N, [&g](int i) {
+        g.write(QByteArray("d") + QByteArray::number(i), double(i));
+    });
+
+    g = root.createGroup("groups");
+    bench("createGroup, creation order", N/10, [&g](int i) {
+        g.createGroup(QByteArray("g") + QByteArray::number(i), true);
+    });
+
+    // 100 runs x 10 channels x 10 datasets
+    g = root.createGroup("catalog");
+    for(int i=0; i<100; ++i) {
+        QH5Group run = g.createGroup(QByteArray("run") + QByteArray::number(i));
+        for(int j=0; j<10; ++j) {
+            QH5Group ch = run.createGroup(QByteArray("ch") + QByteArray::number(j));
+            for(int k=0; k<10; ++k)
+                ch.write(QByteArray("d") + QByteArray::number(k), double(k));
+        }
+    }
+    bench("catalog, recursive subGroups", 10, [&g](int) {
+        descend(g);
+    });
+    bench("catalog, visit", 10, [&g](int) {
+        int n = 0;
+        g.visit([&n](const QH5VisitEntry&) { ++n; return true; });
+    });
+
+    bench("openGroup/openDataset chain", N, [&root](int) {
+        QH5Dataset ds = root.openGroup("catalog").openGroup("run42")
+                .openGroup("ch3").openDataset("d0");
+    });
+    bench("QH5File::dataset, cached", N, [&h5f](int) {
+        QH5Dataset ds = h5f.dataset("catalog/run42/ch3/d0");
+    });
+
+    // 10M samples of a 1 kHz trace, about 3 hours
+    QH5DatasetCreateOptions opt;
+    opt.setChunk({65536});
+    root.createDataset("trace", QH5Dataspace::extendible({0}),
+                       QH5Datatype::fromValue(qint16()), opt);
+    QH5Pyramid pyr = QH5Pyramid::create(root, "trace");
+    QVector<qint16> samples(1 << 20);
+    for(int i=0; i<10; ++i) {
+        for(int j=0; j<samples.size(); ++j) samples[j] = qint16((i*samples.size() + j) % 4096);
+        pyr.append(samples.constData(), samples.size());
+    }
+    quint64 ntrace = 10 << 20;
+    bench("trace view, raw samples", 10, [&root](int) {
+        QVector<double> v;
+        root.openDataset("trace").read(v);
+    });
+    bench("trace view, readDecimated", 10, [&pyr, ntrace](int) {
+        QH5Pyramid::Bins b = pyr.readDecimated(0, ntrace, 2000);
+    });
+
+    // quiet signal, a spike every 1M samples
+    root.createDataset("quiet", QH5Dataspace::extendible({0}),
+                       QH5Datatype::fromValue(float()), opt);
+    QH5ChunkStats qst = QH5ChunkStats::create(root, "quiet");
+    QVector<float> quiet(1 << 20);
+    for(int i=0; i<10; ++i) {
+        for(int j=0; j<quiet.size(); ++j) quiet[j] = 0.001f*(j % 100);
+        quiet[i*1000 + 17] = 5.f;
+        qst.append(quiet.constData(), quiet.size());
+    }
+    bench("threshold scan, all samples", 10, [&qst](int) {
+        QVector<float> v;
+        qst.dataset().read(v);
+        int n = 0;
+        foreach(float x, v) n += x > 1.f;
+        Q_UNUSED(n)
+    });
+    bench("threshold scan, chunk stats", 10, [&qst](int) {
+        QVector<float> v;
+        int n = 0;
+        foreach(quint64 c, qst.select(1., qInf())) {
+            qst.dataset().read(v, qst.chunkSelection(c));
+            foreach(float x, v) n += x > 1.f;
+        }
+        Q_UNUSED(n)
+    });
+
+    // the quiet signal, compressed
+    QH5DatasetCreateOptions zopt;
+    zopt.setChunk({65536});
+    zopt.setDeflate(1);
+    QH5Dataset zds = root.createDataset("quietz", QH5Dataspace::extendible({0}),
+                                        QH5Datatype::fromValue(float()), zopt);
+    for(int i=0; i<10; ++i) zds.append(quiet);
+    bench("sum/min/max, read + loop", 10, [&zds](int) {
+        QVector<float> v;
+        zds.read(v);
+        double sum = 0, mn = qInf(), mx = -qInf();
+        foreach(float x, v) {
+            sum += x;
+            if (x < mn) mn = x;
+            if (x > mx) mx = x;
+        }
+        Q_UNUSED(sum)
+    });
+    bench("sum/min/max, QH5Reduce", 10, [&zds](int) {
+        QH5Reduce r(zds);
+        r.run();
+    });
+
+    }
+    catch (const h5exception& e)
+    {
+        qDebug() << e.what();
+        return -1;
+    }
+
+    return 0;
+}
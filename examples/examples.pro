@@ -2,6 +2,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     demo \
-    hdf5browser
+    hdf5browser \
+    benchmark
     
 
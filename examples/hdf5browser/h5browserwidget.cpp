@@ -2,9 +2,12 @@
 #include "ui_h5browserwidget.h"
 
 #include "qh5filemodel.h"
+#include "qh5datasettablemodel.h"
 
 #include <QFileDialog>
 #include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
 
 template<typename T>
 QTextStream& operator<<(QTextStream& s, const QVector<T>& v)
@@ -13,34 +16,149 @@ QTextStream& operator<<(QTextStream& s, const QVector<T>& v)
         s << "( ";
         for (int i=0; i<v.size()-1; i++) s << v[i] << ", ";
         s << v[v.size()-1] << " )";
-    } else s << v[0];
+    } else if (v.size()==1) s << v[0];
     return s;
 }
 
-QTextStream& operator<<(QTextStream& s, const QStringList& v)
+template<typename T>
+static QString formatValue(const T& v) { return QString::number(v); }
+static QString formatValue(float v) { return QString::number(v, 'g', 7); }
+static QString formatValue(double v) { return QString::number(v, 'g', 15); }
+static QString formatValue(const QString& v) { return "\"" + v + "\""; }
+
+// select the first n and the last n elements in row-major order.
+// Returns false, leaving all selected, if there are at most 2n elements.
+static bool sampleSelection(const QH5Dataspace& sel, int n)
 {
-    if (v.size()>1) {
-        s << "( ";
-        foreach(const QString& t, v) s << "\"" << t << "\", ";
-        s << " )";
-    } else s << v[0];
-    return s;
+    QVector<quint64> dims = sel.dimensions();
+    quint64 total = 1;
+    foreach(quint64 d, dims) total *= d;
+    if (dims.isEmpty() || total <= quint64(2*n)) return false;
+
+    int r = dims.size();
+    QVector<quint64> coords(2*n*r);
+    for(int k=0; k<2*n; ++k) {
+        quint64 i = k < n ? k : total - 2*n + k;
+        for(int d=r-1; d>=0; --d) {
+            coords[k*r + d] = i % dims[d];
+            i /= dims[d];
+        }
+    }
+    return sel.selectElements(coords);
+}
+
+// read the sample of ds into a container C and format it
+template<class C>
+static QString sampleText(const QH5Dataset& ds, int n)
+{
+    QH5Dataspace sel = ds.dataspace();
+    if (sel.selectionSize()==0) return "empty";
+    bool sampled = sampleSelection(sel, n);
+    C v;
+    if (!(sampled ? ds.read(v, sel) : ds.read(v))) return "read error";
+
+    QStringList items;
+    for(int i=0; i<v.size(); ++i) {
+        if (sampled && i==n) items << "...";
+        items << formatValue(v[i]);
+    }
+    return items.size()>1 ? "( " + items.join(", ") + " )" : items[0];
 }
 
+// a sample of the data of ds, read in its native type
+static QString previewText(const QH5Dataset& ds, int n)
+{
+    QH5Datatype dt = ds.datatype();
+    if (dt.getClass()==QH5Datatype::STRING) {
+        if (ds.dataspace().rank()==0) {
+            QString s;
+            return ds.read(s) ? formatValue(s) : QString("read error");
+        }
+        return sampleText<QStringList>(ds, n);
+    }
+
+    switch (dt.metaTypeId())
+    {
+    case QMetaType::Char:
+    case QMetaType::SChar: return sampleText<QVector<qint8> >(ds, n);
+    case QMetaType::UChar: return sampleText<QVector<quint8> >(ds, n);
+    case QMetaType::Short: return sampleText<QVector<qint16> >(ds, n);
+    case QMetaType::UShort: return sampleText<QVector<quint16> >(ds, n);
+    case QMetaType::Int: return sampleText<QVector<qint32> >(ds, n);
+    case QMetaType::UInt: return sampleText<QVector<quint32> >(ds, n);
+    case QMetaType::Long:
+    case QMetaType::LongLong: return sampleText<QVector<qint64> >(ds, n);
+    case QMetaType::ULong:
+    case QMetaType::ULongLong: return sampleText<QVector<quint64> >(ds, n);
+    case QMetaType::Float: return sampleText<QVector<float> >(ds, n);
+    case QMetaType::Double: return sampleText<QVector<double> >(ds, n);
+    default: return "not shown";
+    }
+}
+
+/*
+ * Reads the preview of a dataset on a worker thread and passes it to the widget
+ */
+class QH5PreviewTask : public QRunnable
+{
+    H5BrowserWidget* w_;
+    QH5Dataset ds_;
+    quint64 request_;
+    QSharedPointer<QAtomicInt> cancel_;
+    int n_;
+
+public:
+    QH5PreviewTask(H5BrowserWidget* w, const QH5Dataset& ds, quint64 request,
+                   const QSharedPointer<QAtomicInt>& cancel, int n) :
+        w_(w), ds_(ds), request_(request), cancel_(cancel), n_(n)
+    {}
+
+    void run() override
+    {
+        if (cancel_->load()) return;
+
+        QString S;
+        try {
+            S = previewText(ds_, n_);
+        }
+        catch (const h5exception& e) {
+            S = QString("error, %1").arg(e.what());
+        }
+
+        if (cancel_->load()) return;
+        H5BrowserWidget* w = w_;
+        quint64 request = request_;
+        QMetaObject::invokeMethod(w, [w, request, S]() {
+            w->showPreview(request, S);
+        }, Qt::QueuedConnection);
+    }
+};
+
 H5BrowserWidget::H5BrowserWidget(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::H5BrowserWidget)
+    , previewRequest_(0)
+    , previewSize_(10)
 {
     ui->setupUi(this);
 
     model_ = new QH5FileModel(this);
+    tableModel_ = new QH5DatasetTableModel(this);
+    ui->tableView->setModel(tableModel_);
+
+    previewPool_ = new QThreadPool(this);
+    previewPool_->setMaxThreadCount(1);
 
     connect(ui->btOpen, SIGNAL(pressed()), this, SLOT(openPressed()));
     connect(ui->treeView, &QTreeView::clicked, this, &H5BrowserWidget::on_treeView_activated);
+    // stop loading the members of a group when it is collapsed
+    connect(ui->treeView, &QTreeView::collapsed, model_, &QH5FileModel::cancelFetch);
 }
 
 H5BrowserWidget::~H5BrowserWidget()
 {
+    cancelPreview();
+    previewPool_->waitForDone();
     delete ui;
 }
 
@@ -50,7 +168,10 @@ void H5BrowserWidget::openPressed()
                                                  "Select HDF5 file");
 
     if (!fname.isEmpty() && QH5File::isHDF5(fname)) {
+        cancelPreview();
+        ui->edtField->clear();
         ui->treeView->setModel(0);
+        tableModel_->setDataset(QH5Dataset());
         model_ ->setFile(fname);
         ui->treeView->setModel(model_);
         ui->edtFileName->setText(fname);
@@ -58,52 +179,102 @@ void H5BrowserWidget::openPressed()
 
 }
 
+void H5BrowserWidget::cancelPreview()
+{
+    previewRequest_++;
+    if (previewCancel_) {
+        previewCancel_->store(1);
+        previewCancel_.clear();
+    }
+}
+
+void H5BrowserWidget::showPreview(quint64 request, const QString& text)
+{
+    if (request != previewRequest_) return; // the selection has changed
+    previewCancel_.clear();
+    ui->edtField->setPlainText(previewHeader_ + "Data: " + text);
+}
 
 void H5BrowserWidget::on_treeView_activated(const QModelIndex &index)
 {
+    cancelPreview();
+
     QString S;
     QTextStream str(&S);
     QH5Node node = model_->h5node(index);
-
+    QH5Dataset ds;
 
     if (node.isGroup()) {
         str << node.name() << ": Group";
     } else if (node.isDataset())
     {
-        QH5Dataset ds = node.toDataset();
+        // only metadata here, the data are read by the preview task
+        ds = node.toDataset();
         str << node.name() << ": Dataset" << endl;
+
+        QVector<quint64> dims = ds.dataspace().dimensions();
+        quint64 npoints = 1;
+        foreach(quint64 d, dims) npoints *= d;
+        str << "Shape: ";
+        if (dims.isEmpty()) str << "scalar";
+        else str << dims;
+        str << endl;
+
         QH5Datatype dt = ds.datatype();
-        QH5Datatype::Class cls = dt.getClass();
-        if (cls==QH5Datatype::FLOAT) {
-            QVector<double> v;
-            ds.read(v);
-            str << "Type: FLOAT" << endl;
-            str << "Size: " << v.size() << endl;
-            str << "Data: " << v;
-        } else if (cls==QH5Datatype::INTEGER) {
-            QVector<int> v;
-            ds.read(v);
-            str << "Type: INT" << endl;
-            str << "Size: " << v.size() << endl;
-            str << "Data: " << v;
-        } else if (cls==QH5Datatype::STRING) {
-            QStringList v;
-            ds.read(v);
-            str << "Type: STRING" << endl;
-            str << "Size: " << v.size() << endl;
-            str << "Data: " << v;
-        }
-        else {
-            str << "Type: Unknown" << endl;
+        static const char* classNames[] = {
+            "Unknown", "INTEGER", "FLOAT", "STRING", "COMPOUND", "ARRAY"
+        };
+        str << "Type: " << classNames[dt.getClass()];
+        if (dt.getClass()==QH5Datatype::INTEGER || dt.getClass()==QH5Datatype::FLOAT) {
+            int id = dt.metaTypeId();
+            if (id != QMetaType::UnknownType) str << " (" << QMetaType::typeName(id) << ")";
         }
+        str << ", " << dt.size() << " bytes" << endl;
+
+        QH5DatasetCreateOptions opt = ds.createOptions();
+        str << "Layout: ";
+        if (opt.isChunked()) str << "chunked " << opt.chunk();
+        else str << "contiguous";
+        str << endl;
 
+        QStringList filters;
+        if (opt.shuffle()) filters << "shuffle";
+        if (opt.deflate() >= 0) filters << QString("deflate %1").arg(opt.deflate());
+        if (opt.nbit()) filters << "nbit";
+        if (opt.scaleOffset()) filters << QString("scaleoffset %1").arg(opt.scaleOffsetFactor());
+        if (opt.fletcher32()) filters << "fletcher32";
+        str << "Filters: " << (filters.isEmpty() ? QString("none") : filters.join(", ")) << endl;
+
+        quint64 logical = npoints * dt.size();
+        quint64 stored = ds.storageSize();
+        str << "Storage: " << stored << " bytes, logical " << logical << " bytes";
+        if (stored) str << QString(", ratio %1").arg(double(logical)/stored, 0, 'f', 2);
+        str << endl;
+
+        // numeric data are also shown in the table
+        if (!tableModel_->setDataset(ds) &&
+                (dt.getClass()==QH5Datatype::INTEGER || dt.getClass()==QH5Datatype::FLOAT))
+            str << "Table: rank > 2, not shown" << endl;
     }
     else str << "Unknown Object";
 
     str.flush();
 
-    ui->edtField->setPlainText(S);
-
-
+    if (!ds.isValid()) {
+        tableModel_->setDataset(QH5Dataset());
+        ui->edtField->setPlainText(S);
+        return;
+    }
 
+    previewHeader_ = S;
+    ui->edtField->setPlainText(previewHeader_ + "Data: loading...");
+    previewCancel_ = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    QH5PreviewTask* task = new QH5PreviewTask(this, ds, previewRequest_,
+                                              previewCancel_, previewSize_);
+    if (QH5File::isThreadSafe()) previewPool_->start(task);
+    else {
+        // HDF5 must not be called from two threads
+        task->run();
+        delete task;
+    }
 }
@@ -2,8 +2,13 @@
 #define H5BROWSERWIDGET_H
 
 #include <QWidget>
+#include <QSharedPointer>
+#include <QAtomicInt>
 
 class QH5FileModel;
+class QH5DatasetTableModel;
+class QH5PreviewTask;
+class QThreadPool;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class H5BrowserWidget; }
@@ -13,10 +18,20 @@ class H5BrowserWidget : public QWidget
 {
     Q_OBJECT
 
+    friend class QH5PreviewTask;
+
 public:
     H5BrowserWidget(QWidget *parent = nullptr);
     ~H5BrowserWidget();
 
+    /*!
+     * \brief Set the number of elements shown from the start and from the end of a dataset
+     *
+     * At least 1 element is shown. The default is 10.
+     */
+    void setPreviewSize(int n) { previewSize_ = qMax(1, n); }
+    int previewSize() const { return previewSize_; }
+
 public slots:
     void openPressed();
 
@@ -27,6 +42,17 @@ private:
     Ui::H5BrowserWidget *ui;
 
     QH5FileModel* model_;
+    QH5DatasetTableModel* tableModel_;
+
+    // dataset preview, read on a worker thread
+    QThreadPool* previewPool_;
+    QString previewHeader_;             // metadata summary of the current node
+    quint64 previewRequest_;            // id of the current preview
+    QSharedPointer<QAtomicInt> previewCancel_;
+    int previewSize_;
+
+    void cancelPreview();
+    void showPreview(quint64 request, const QString& text);
 
 
 };
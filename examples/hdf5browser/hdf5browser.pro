@@ -20,10 +20,12 @@ include(../../src/qthdf5/qthdf5.pri)
 SOURCES += \
     main.cpp \
     h5browserwidget.cpp \
+    qh5datasettablemodel.cpp \
     qh5filemodel.cpp
 
 HEADERS += \
     h5browserwidget.h \
+    qh5datasettablemodel.h \
     qh5filemodel.h
 
 FORMS += \
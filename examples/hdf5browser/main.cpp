@@ -22,6 +22,10 @@ int main(int argc, char *argv[])
  * to display the information stored in HDF5 files and thus
  * create a simple HDF5 file browser.
  *
+ * The browser reads group members and dataset values on worker threads
+ * if the HDF5 library is thread-safe (see QH5File::isThreadSafe()),
+ * otherwise on the GUI thread.
+ *
  * \image html qthdf5-file-browser.png
  *
  */
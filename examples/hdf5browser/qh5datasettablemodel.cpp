@@ -0,0 +1,283 @@
+#include "qh5datasettablemodel.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+
+#include <climits>
+#include <cstring>
+
+/*
+ * Reads a block on the worker thread and passes it to the model
+ */
+class QH5BlockReader : public QRunnable
+{
+    QH5DatasetTableModel* model_;
+    QH5Dataset ds_;
+    QH5DatasetTableModel::Kind kind_;
+    int rank_;
+    quint64 r0_, nr_, c0_, nc_;
+    quint64 generation_, key_;
+
+public:
+    QH5BlockReader(QH5DatasetTableModel* m, const QH5Dataset& ds,
+                   QH5DatasetTableModel::Kind kind, int rank,
+                   quint64 r0, quint64 nr, quint64 c0, quint64 nc,
+                   quint64 generation, quint64 key) :
+        model_(m), ds_(ds), kind_(kind), rank_(rank),
+        r0_(r0), nr_(nr), c0_(c0), nc_(nc), generation_(generation), key_(key)
+    {}
+
+    void run() override
+    {
+        QByteArray data;
+        try {
+            data = QH5DatasetTableModel::readBlock(ds_, kind_, rank_, r0_, nr_, c0_, nc_);
+        }
+        catch (const h5exception& e) {
+            qWarning("QH5DatasetTableModel: %s", e.what());
+        }
+
+        QH5DatasetTableModel* m = model_;
+        quint64 generation = generation_, key = key_;
+        int cols = int(nc_);
+        QMetaObject::invokeMethod(m, [m, generation, key, data, cols]() {
+            m->insertBlock(generation, key, data, cols);
+        }, Qt::QueuedConnection);
+    }
+};
+
+// block length along a dimension: a multiple of the chunk size near want, at most maxLen
+static quint64 blockLength(quint64 want, quint64 chunk, quint64 maxLen, quint64 dim)
+{
+    quint64 n = want;
+    if (chunk) n = chunk >= want ? chunk : ((want + chunk - 1)/chunk)*chunk;
+    n = qMin(n, maxLen);
+    return qMax<quint64>(1, qMin(n, dim));
+}
+
+QH5DatasetTableModel::QH5DatasetTableModel(QObject *parent) :
+    QAbstractTableModel(parent), kind_(NONE), rank_(0), rows_(0), cols_(0),
+    blockRows_(1), blockCols_(1), cache_(16 << 20), lastRow_(0), lastCol_(0),
+    blocksRead_(0), generation_(0)
+{
+    worker_ = new QThreadPool(this);
+    worker_->setMaxThreadCount(1);
+}
+
+QH5DatasetTableModel::~QH5DatasetTableModel()
+{
+    worker_->waitForDone();
+}
+
+bool QH5DatasetTableModel::setDataset(const QH5Dataset& ds)
+{
+    beginResetModel();
+
+    generation_++;
+    cache_.clear();
+    pending_.clear();
+    failed_.clear();
+    ds_ = ds;
+    kind_ = NONE;
+    rank_ = 0;
+    rows_ = cols_ = 0;
+    lastRow_ = lastCol_ = 0;
+    blocksRead_ = 0;
+
+    if (ds_.isValid()) {
+        QH5Datatype t = ds_.datatype();
+        switch (t.getClass())
+        {
+        case QH5Datatype::INTEGER:
+            switch (t.metaTypeId())
+            {
+            case QMetaType::UChar:
+            case QMetaType::UShort:
+            case QMetaType::UInt:
+            case QMetaType::ULong:
+            case QMetaType::ULongLong:
+                kind_ = UNSIGNED;
+                break;
+            default:
+                kind_ = SIGNED;
+            }
+            break;
+        case QH5Datatype::FLOAT:
+            kind_ = REAL;
+            break;
+        default:
+            break;
+        }
+
+        QVector<quint64> dims = ds_.dataspace().dimensions();
+        rank_ = dims.size();
+        if (rank_ > 2) kind_ = NONE;
+    }
+
+    if (kind_ != NONE) {
+        QVector<quint64> dims = ds_.dataspace().dimensions();
+        QVector<quint64> chunk = ds_.createOptions().chunk();
+        rows_ = rank_ > 0 ? dims[0] : 1;
+        cols_ = rank_ > 1 ? dims[1] : 1;
+        if (rank_ < 2) {
+            blockRows_ = blockLength(4096, chunk.isEmpty() ? 0 : chunk[0], 65536, rows_);
+            blockCols_ = 1;
+        } else {
+            blockRows_ = blockLength(256, chunk.isEmpty() ? 0 : chunk[0], 4096, rows_);
+            blockCols_ = blockLength(64, chunk.isEmpty() ? 0 : chunk[1], 1024, cols_);
+        }
+        // room for the current block and a prefetched one at least
+        int blockBytes = int(blockRows_*blockCols_*8);
+        if (cache_.maxCost() < 2*blockBytes) cache_.setMaxCost(2*blockBytes);
+    }
+
+    endResetModel();
+    return kind_ != NONE;
+}
+
+void QH5DatasetTableModel::setCacheSize(int bytes)
+{
+    int blockBytes = int(blockRows_*blockCols_*8);
+    cache_.setMaxCost(qMax(bytes, 2*blockBytes));
+}
+
+int QH5DatasetTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(qMin<quint64>(rows_, INT_MAX));
+}
+
+int QH5DatasetTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(qMin<quint64>(cols_, INT_MAX));
+}
+
+QVariant QH5DatasetTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole || kind_ == NONE)
+        return QVariant();
+
+    quint64 r = index.row(), c = index.column();
+    quint64 br = r / blockRows_, bc = c / blockCols_;
+
+    // entering a new block: read ahead in the direction of movement
+    if (br != lastRow_ || bc != lastCol_) {
+        quint64 nbr = br + (br > lastRow_) - (br < lastRow_);
+        quint64 nbc = bc + (bc > lastCol_) - (bc < lastCol_);
+        lastRow_ = br;
+        lastCol_ = bc;
+        requestBlock(nbr, nbc);
+    }
+
+    // never read on the GUI thread, the element is shown when the block arrives
+    const Block* b = cache_.object(blockKey(br, bc));
+    if (!b) {
+        requestBlock(br, bc);
+        return QVariant();
+    }
+
+    const char* p = b->data.constData() +
+            ((r - br*blockRows_)*b->cols + (c - bc*blockCols_))*8;
+    switch (kind_)
+    {
+    case SIGNED: {
+        qint64 v;
+        memcpy(&v, p, 8);
+        return QVariant(v);
+    }
+    case UNSIGNED: {
+        quint64 v;
+        memcpy(&v, p, 8);
+        return QVariant(v);
+    }
+    case REAL: {
+        double v;
+        memcpy(&v, p, 8);
+        return QVariant(v);
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant QH5DatasetTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    Q_UNUSED(orientation)
+    if (role != Qt::DisplayRole) return QVariant();
+    return section;
+}
+
+quint64 QH5DatasetTableModel::blockKey(quint64 br, quint64 bc) const
+{
+    quint64 nbc = (cols_ + blockCols_ - 1) / blockCols_;
+    return br*nbc + bc;
+}
+
+void QH5DatasetTableModel::requestBlock(quint64 br, quint64 bc) const
+{
+    // also rejects "negative" coordinates, which wrap around
+    quint64 r0 = br*blockRows_, c0 = bc*blockCols_;
+    if (br >= (rows_ + blockRows_ - 1)/blockRows_ || bc >= (cols_ + blockCols_ - 1)/blockCols_)
+        return;
+
+    quint64 key = blockKey(br, bc);
+    if (cache_.contains(key) || pending_.contains(key) || failed_.contains(key)) return;
+    pending_.insert(key);
+
+    quint64 nr = qMin(blockRows_, rows_ - r0), nc = qMin(blockCols_, cols_ - c0);
+    QH5DatasetTableModel* self = const_cast<QH5DatasetTableModel*>(this);
+    QH5BlockReader* reader = new QH5BlockReader(self, ds_, kind_, rank_, r0, nr, c0, nc,
+                                                generation_, key);
+    if (QH5File::isThreadSafe()) worker_->start(reader);
+    else {
+        // HDF5 must not be called from two threads, the block is still inserted later
+        reader->run();
+        delete reader;
+    }
+}
+
+void QH5DatasetTableModel::insertBlock(quint64 generation, quint64 key,
+                                       const QByteArray& data, int cols)
+{
+    if (generation != generation_) return; // for a previous dataset
+    pending_.remove(key);
+    if (data.isEmpty()) {
+        // the error was reported by the reader, the elements stay empty
+        failed_.insert(key);
+        return;
+    }
+    if (cache_.contains(key)) return;
+
+    Block* b = new Block;
+    b->data = data;
+    b->cols = cols;
+    blocksRead_++;
+    cache_.insert(key, b, data.size());
+
+    // the views show the block elements as empty until now
+    quint64 nbc = (cols_ + blockCols_ - 1) / blockCols_;
+    quint64 r0 = (key / nbc)*blockRows_, c0 = (key % nbc)*blockCols_;
+    if (r0 > INT_MAX || c0 > INT_MAX) return; // beyond rowCount() or columnCount()
+    quint64 r1 = qMin(r0 + blockRows_, rows_) - 1, c1 = qMin(c0 + blockCols_, cols_) - 1;
+    emit dataChanged(index(int(r0), int(c0)),
+                     index(int(qMin<quint64>(r1, INT_MAX)), int(qMin<quint64>(c1, INT_MAX))));
+}
+
+QByteArray QH5DatasetTableModel::readBlock(const QH5Dataset& ds, Kind kind, int rank,
+                                           quint64 r0, quint64 nr, quint64 c0, quint64 nc)
+{
+    QH5Dataspace fs = ds.dataspace();
+    if (rank == 1) fs.selectHyperslab({r0}, {nr});
+    else if (rank == 2) fs.selectHyperslab({r0, c0}, {nr, nc});
+
+    quint64 n = rank ? nr*nc : 1;
+    QByteArray data(int(n*8), Qt::Uninitialized);
+    bool ok = false;
+    switch (kind)
+    {
+    case SIGNED: ok = ds.read(reinterpret_cast<qint64*>(data.data()), n, fs); break;
+    case UNSIGNED: ok = ds.read(reinterpret_cast<quint64*>(data.data()), n, fs); break;
+    case REAL: ok = ds.read(reinterpret_cast<double*>(data.data()), n, fs); break;
+    default: break;
+    }
+    return ok ? data : QByteArray();
+}
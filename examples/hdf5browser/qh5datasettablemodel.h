@@ -0,0 +1,113 @@
+#ifndef QH5DATASETTABLEMODEL_H
+#define QH5DATASETTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QSet>
+
+#include "qthdf5.h"
+
+class QThreadPool;
+class QH5BlockReader;
+
+/**
+ * @brief A Qt table model presenting the elements of a 1D or 2D dataset
+ *
+ * The model reads only the elements that are requested by a view.
+ * The dataset is divided in rectangular blocks, aligned to its chunks if the
+ * layout is chunked, and each block is read with a single hyperslab selection
+ * when one of its elements is first needed.
+ *
+ * The blocks are read on a worker thread, so that data() never blocks the GUI,
+ * or on the GUI thread if the HDF5 library is not thread-safe (see QH5File::isThreadSafe()).
+ * Until its block has been read an element is returned as an invalid QVariant,
+ * and dataChanged() is emitted for the block when it arrives.
+ * A block that cannot be read is reported once with qWarning() and its elements
+ * stay invalid until the next setDataset().
+ *
+ * The blocks are kept in an LRU cache of fixed size (see setCacheSize()), so that
+ * the memory use does not depend on the size of the dataset.
+ * When the view moves to a new block, the next block in the same direction
+ * is read in advance.
+ *
+ * \code
+ * QH5DatasetTableModel* model = new QH5DatasetTableModel(this);
+ * model->setDataset(h5f.dataset("run42/ch3/adc"));
+ * tableView->setModel(model);
+ * \endcode
+ *
+ * A 1D dataset is shown as a single column. Integer and floating point
+ * datasets are supported.
+ *
+ */
+class QH5DatasetTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+    friend class QH5BlockReader;
+
+public:
+    explicit QH5DatasetTableModel(QObject *parent = 0);
+    virtual ~QH5DatasetTableModel();
+
+    /*!
+     * \brief Set the dataset presented by the model
+     *
+     * \return true if the dataset is supported. Otherwise the model is empty.
+     */
+    bool setDataset(const QH5Dataset& ds);
+
+    /*!
+     * \brief Return the dataset presented by the model
+     */
+    const QH5Dataset& dataset() const { return ds_; }
+
+    /*!
+     * \brief Set the capacity of the block cache in bytes. The default is 16 MiB.
+     */
+    void setCacheSize(int bytes);
+
+    /*!
+     * \brief Number of blocks read from the file since the last setDataset()
+     */
+    int blocksRead() const { return blocksRead_; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    // element type of the blocks in memory
+    enum Kind { NONE, SIGNED, UNSIGNED, REAL };
+
+    // 8-byte elements in row-major order
+    struct Block {
+        QByteArray data;
+        int cols;
+    };
+
+    QH5Dataset ds_;
+    Kind kind_;
+    int rank_;
+    quint64 rows_, cols_;
+    quint64 blockRows_, blockCols_;
+
+    mutable QCache<quint64, Block> cache_;
+    mutable QSet<quint64> pending_; // blocks being read
+    QSet<quint64> failed_;          // blocks that could not be read, not requested again
+    mutable quint64 lastRow_, lastCol_; // block coordinates of the last access
+    mutable int blocksRead_;
+    quint64 generation_;            // incremented by setDataset()
+
+    QThreadPool* worker_;
+
+    quint64 blockKey(quint64 br, quint64 bc) const;
+    void requestBlock(quint64 br, quint64 bc) const;
+    void insertBlock(quint64 generation, quint64 key, const QByteArray& data, int cols);
+
+    static QByteArray readBlock(const QH5Dataset& ds, Kind kind, int rank,
+                                quint64 r0, quint64 nr, quint64 c0, quint64 nc);
+};
+
+#endif // QH5DATASETTABLEMODEL_H
@@ -3,51 +3,58 @@
 #include <QImage>
 #include <QIcon>
 #include <QFileIconProvider>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QElapsedTimer>
 
 class Node
 {
 public:
     QList<Node*> children;
     QByteArray name;
-    QH5Node h5obj;
+    QByteArray path; // relative to the root group, empty for the root
+    QH5Node::Type type;
     Node *parent;
-
-    explicit Node(const QByteArray& n, const QH5Node& obj, Node *parentItem = 0) :
+    int rowInParent;
+    bool fetched;    // true if the children have been read or are loading
+    int members;     // 1 if a group has group or dataset members, 0 if not, -1 if not known yet
+    bool placeholder;// "Loading..." row
+    quint64 request; // id of the listing in progress, 0 if none
+    QSharedPointer<QAtomicInt> cancel; // cancel flag of the listing in progress
+
+    explicit Node(const QByteArray& n, const QByteArray& p, QH5Node::Type t,
+                  Node *parentItem = 0, int row = 0) :
         name(n),
-        h5obj(obj),
-        parent(parentItem)
+        path(p),
+        type(t),
+        parent(parentItem),
+        rowInParent(row),
+        fetched(t != QH5Node::GROUP),
+        members(-1),
+        placeholder(false),
+        request(0)
     {}
 
-    void populate()
-    {
-        if (!h5obj.isGroup()) return;
-        QH5Group h5g = h5obj.toGroup();
-        foreach (const QByteArray& name, h5g.groupNames()) {
-            Node* n = new Node(name,h5g.openGroup(name),this);
-            children.push_back(n);
-            n->populate();
-        }
-        foreach (const QByteArray& name, h5g.datasetNames()) {
-            Node* n = new Node(name,h5g.openDataset(name),this);
-            children.push_back(n);
-            n->populate();
-        }
-    }
     void deleteChildren()
     {
         foreach (Node* n, children) {
             n->deleteChildren();
             delete n;
         }
+        children.clear();
     }
 
-    void appendChild(Node *child)
+    // insert before the placeholder, which is the last child while loading
+    void insertChild(const QH5GroupEntry& e, bool hasMembers)
     {
-        children.push_back(child);
-    }
-    void insertChild(int row, Node* child)
-    {
-        children.insert(row,child);
+        QByteArray p = path.isEmpty() ? e.name : path + '/' + e.name;
+        int row = children.size() - 1;
+        Node* nd = new Node(e.name, p, e.type, this, row);
+        nd->members = hasMembers ? 1 : 0;
+        children.insert(row, nd);
+        children.last()->rowInParent = row + 1;
     }
 
     Node *child(int row)
@@ -58,21 +65,110 @@ public:
     {
         return children.size();
     }
-    int row()
+    int row() const
+    {
+        return parent ? rowInParent : -1;
+    }
+};
+
+/*
+ * True if group name in loc has any links, loc itself if name is empty.
+ * Only the group info is read, the group is not opened or iterated.
+ */
+static bool hasLinks(const QH5Group& loc, const QByteArray& name)
+{
+    try {
+        return loc.linkCount(name.isEmpty() ? "." : name.constData()) > 0;
+    }
+    catch (const h5exception& e) {
+        qWarning("QH5FileModel: %s", e.what());
+        return false;
+    }
+}
+
+/*
+ * Lists the members of a group on the worker thread and passes them
+ * to the model in batches.
+ *
+ * The group is iterated in slices of at most one batch or 16 ms, so that
+ * the HDF5 library lock is released in between and the GUI thread is not
+ * blocked by a long listing.
+ */
+class QH5GroupLister : public QRunnable
+{
+    QH5FileModel* model_;
+    QH5Group root_;
+    QByteArray path_;
+    quint64 request_;
+    QSharedPointer<QAtomicInt> cancel_;
+    int batchSize_;
+
+public:
+    QH5GroupLister(QH5FileModel* m, const QH5Group& root, const QByteArray& path,
+                   quint64 request, const QSharedPointer<QAtomicInt>& cancel, int batchSize) :
+        model_(m), root_(root), path_(path), request_(request), cancel_(cancel),
+        batchSize_(batchSize)
+    {}
+
+    void run() override
+    {
+        QVector<QH5GroupEntry> batch;
+        QVector<bool> members;
+        try {
+            QH5Group g = path_.isEmpty() ? root_ : root_.openGroup(path_.constData());
+            quint64 pos = 0;
+            bool done = !g.isValid();
+            while (!done && !cancel_->load()) {
+                QElapsedTimer t;
+                t.start();
+                done = g.iterate([&](const QH5GroupEntry& e) {
+                    if (e.type == QH5Node::GROUP || e.type == QH5Node::DATASET)
+                        batch.push_back(e);
+                    return batch.size() < batchSize_ && t.elapsed() < 16;
+                }, false, &pos);
+
+                // one group info call for each child group
+                members.resize(batch.size());
+                for (int i = 0; i < batch.size() && !cancel_->load(); ++i)
+                    members[i] = batch[i].type == QH5Node::GROUP && hasLinks(g, batch[i].name);
+
+                if (!done && !batch.isEmpty()) {
+                    post(batch, members, false);
+                    batch.clear();
+                }
+            }
+        }
+        catch (const h5exception& e) {
+            qWarning("QH5FileModel: %s", e.what());
+            members.resize(batch.size());
+        }
+        post(batch, members, true);
+    }
+
+private:
+    void post(const QVector<QH5GroupEntry>& batch, const QVector<bool>& members, bool last)
     {
-        if (!parent) return -1;
-        return parent->children.indexOf(this);
+        if (cancel_->load()) return;
+        QH5FileModel* m = model_;
+        quint64 request = request_;
+        QMetaObject::invokeMethod(m, [m, request, batch, members, last]() {
+            m->insertBatch(request, batch, members, last);
+        }, Qt::QueuedConnection);
     }
 };
 
 QH5FileModel::QH5FileModel(QObject *parent) :
-    QAbstractItemModel(parent), rootNode(0)
+    QAbstractItemModel(parent), rootNode(0), lastRequest(0), batchSize(1000)
 {
     iconProvider = new QFileIconProvider;
+    // a single thread, so that HDF5 calls of the listings do not compete
+    worker = new QThreadPool(this);
+    worker->setMaxThreadCount(1);
 }
 
 QH5FileModel::~QH5FileModel()
 {
+    cancelAll();
     if (rootNode) {
         Node* ptr = (Node*)rootNode;
         ptr->deleteChildren();
@@ -84,23 +180,32 @@ QH5FileModel::~QH5FileModel()
 
 void QH5FileModel::setFile(const QString& fname)
 {
+    cancelAll();
+
+    beginResetModel();
+
     if (rootNode) {
         Node* ptr = (Node*)rootNode;
         ptr->deleteChildren();
         delete ptr;
         rootNode = 0;
+        rootGroup = QH5Group();
         hdf5file.close();
     }
 
-    if (fname.isNull() || fname.isEmpty()) return;
-
-    hdf5file.setFileName(fname);
+    if (!fname.isEmpty()) {
+        hdf5file.setFileName(fname);
 
-    if (hdf5file.open(QIODevice::ReadOnly)) {
-        Node* ptr = new Node("/",hdf5file.root());
-        ptr->populate();
-        rootNode = (void*)ptr;
+        if (hdf5file.open(QIODevice::ReadOnly)) {
+            rootGroup = hdf5file.root();
+            Node* nd = new Node("/", QByteArray(), QH5Node::GROUP);
+            // for members the flag is computed by the listing of their parent
+            nd->members = hasLinks(rootGroup, QByteArray()) ? 1 : 0;
+            rootNode = (void*)nd;
+        }
     }
+
+    endResetModel();
 }
 
 QVariant QH5FileModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -184,7 +289,7 @@ int QH5FileModel::rowCount(const QModelIndex &parent) const
     if (parent.column() > 0)
          return 0;
 
-    if (!parent.isValid()) return 1;
+    if (!parent.isValid()) return rootNode ? 1 : 0;
 
     Node* parentNode = (Node*)parent.internalPointer();
     Q_ASSERT(parentNode);
@@ -202,25 +307,123 @@ bool QH5FileModel::hasChildren(const QModelIndex &parent) const
     if (parent.column() > 0)
         return false;
 
-    if (!parent.isValid()) return true;
+    if (!parent.isValid()) return rootNode != 0;
 
     Node* parentNode = (Node*)parent.internalPointer();
     Q_ASSERT(parentNode);
 
-    return (!parentNode->children.isEmpty());
+    if (parentNode->type != QH5Node::GROUP) return false;
+    if (parentNode->fetched) return !parentNode->children.isEmpty();
+
+    // set when the node was listed, no HDF5 calls on the GUI thread
+    return parentNode->members > 0;
 }
 
 bool QH5FileModel::canFetchMore(const QModelIndex &parent) const
 {
-    // FIXME: Implement me!
-    Q_UNUSED(parent)
-    return false;
+    if (!parent.isValid() || parent.column() > 0) return false;
+
+    Node* parentNode = (Node*)parent.internalPointer();
+    Q_ASSERT(parentNode);
+
+    return !parentNode->fetched;
 }
 
 void QH5FileModel::fetchMore(const QModelIndex &parent)
 {
-    // FIXME: Implement me!
-    Q_UNUSED(parent)
+    if (!canFetchMore(parent)) return;
+
+    Node* parentNode = (Node*)parent.internalPointer();
+    parentNode->fetched = true;
+
+    beginInsertRows(parent, 0, 0);
+    Node* p = new Node(tr("Loading...").toUtf8(), QByteArray(), QH5Node::UNKNOWN, parentNode, 0);
+    p->placeholder = true;
+    parentNode->children.push_back(p);
+    endInsertRows();
+
+    parentNode->request = ++lastRequest;
+    parentNode->cancel = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    loading.insert(parentNode->request, parentNode);
+    // the group is opened on the worker
+    QH5GroupLister* lister = new QH5GroupLister(this, rootGroup, parentNode->path,
+                                                parentNode->request, parentNode->cancel, batchSize);
+    if (QH5File::isThreadSafe()) worker->start(lister);
+    else {
+        // HDF5 must not be called from two threads, the batches are still queued
+        lister->run();
+        delete lister;
+    }
+}
+
+void QH5FileModel::insertBatch(quint64 request, const QVector<QH5GroupEntry>& batch,
+                               const QVector<bool>& members, bool last)
+{
+    Node* nd = (Node*)loading.value(request);
+    if (!nd) return; // cancelled
+
+    QModelIndex parent = nodeIndex(nd);
+
+    if (!batch.isEmpty()) {
+        int row = nd->children.size() - 1;
+        beginInsertRows(parent, row, row + batch.size() - 1);
+        for (int i = 0; i < batch.size(); ++i) nd->insertChild(batch[i], members[i]);
+        endInsertRows();
+    }
+
+    if (last) {
+        int row = nd->children.size() - 1;
+        beginRemoveRows(parent, row, row);
+        delete nd->children.takeLast();
+        endRemoveRows();
+
+        loading.remove(request);
+        nd->request = 0;
+        nd->cancel.clear();
+    }
+}
+
+void QH5FileModel::cancelFetch(const QModelIndex& parent)
+{
+    if (!parent.isValid()) return;
+
+    Node* nd = (Node*)parent.internalPointer();
+    Q_ASSERT(nd);
+    if (!nd->request) return;
+
+    // also cancel expanded members that are still loading
+    cancelTree(nd);
+
+    // drop the partial listing, fetchMore() starts over
+    beginRemoveRows(parent, 0, nd->children.size() - 1);
+    nd->deleteChildren();
+    endRemoveRows();
+    nd->fetched = false;
+}
+
+void QH5FileModel::cancelTree(void* node)
+{
+    Node* nd = (Node*)node;
+    if (nd->request) {
+        nd->cancel->store(1);
+        loading.remove(nd->request);
+        nd->request = 0;
+        nd->cancel.clear();
+    }
+    foreach (Node* n, nd->children) cancelTree(n);
+}
+
+void QH5FileModel::cancelAll()
+{
+    if (rootNode) cancelTree(rootNode);
+    // the listings hold group handles, they must finish before the file is closed
+    worker->waitForDone();
+}
+
+QModelIndex QH5FileModel::nodeIndex(void* node) const
+{
+    Node* nd = (Node*)node;
+    return createIndex(nd->parent ? nd->row() : 0, 0, nd);
 }
 
 QVariant QH5FileModel::data(const QModelIndex &index, int role) const
@@ -231,14 +434,17 @@ QVariant QH5FileModel::data(const QModelIndex &index, int role) const
     Node* nd = (Node*)index.internalPointer();
     Q_ASSERT(nd);
 
+    if (nd->placeholder)
+        return role == Qt::DisplayRole && index.column() == 0 ? QVariant(nd->name) : QVariant();
+
     switch (role) {
     case Qt::EditRole:
     case Qt::DisplayRole:
         switch (index.column()) {
         case 0: return nd->name;
         case 1:
-            if (nd->h5obj.isGroup()) return "Group";
-            else if (nd->h5obj.isDataset()) return "Dataset";
+            if (nd->type == QH5Node::GROUP) return "Group";
+            else if (nd->type == QH5Node::DATASET) return "Dataset";
             else return "";
         default:
             qWarning("data: invalid display value column %d", index.column());
@@ -247,9 +453,9 @@ QVariant QH5FileModel::data(const QModelIndex &index, int role) const
         break;
     case Qt::DecorationRole:
         if (index.column() == 0) {
-            if (nd->h5obj.isGroup())
+            if (nd->type == QH5Node::GROUP)
                 return iconProvider->icon(QFileIconProvider::Folder);
-            else if (nd->h5obj.isDataset())
+            else if (nd->type == QH5Node::DATASET)
                 return iconProvider->icon(QFileIconProvider::File);
             else return QIcon();
         }
@@ -268,6 +474,9 @@ QH5Node QH5FileModel::h5node(const QModelIndex &index) const
     Node* nd = (Node*)index.internalPointer();
     Q_ASSERT(nd);
 
-    return nd->h5obj;
+    if (!nd->parent) return rootGroup;
+    if (nd->type == QH5Node::GROUP) return hdf5file.group(nd->path);
+    if (nd->type == QH5Node::DATASET) return hdf5file.dataset(nd->path);
+    return QH5Node();
 }
 
@@ -2,10 +2,13 @@
 #define QH5FILEMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
 
 #include "qthdf5.h"
 
 class QFileIconProvider;
+class QThreadPool;
+class QH5GroupLister;
 
 /**
  * @brief Defines a Qt item model for HDF5 files
@@ -19,7 +22,22 @@ class QFileIconProvider;
  * model.setFile("FILENAME.H5");
  * \endcode
  *
- * The item model is internally populated with all nodes (groups, datasets) in the file.
+ * The item model is populated lazily: the members of a group are read
+ * only when the group is expanded in a view (see canFetchMore() and fetchMore()).
+ * The model nodes store only the path and type of each object, so that
+ * memory use is proportional to the number of expanded items.
+ *
+ * The members are listed on a worker thread and inserted in batches, so that
+ * the GUI stays responsive while a large group is loading. Until the listing
+ * is complete a "Loading..." placeholder row is shown as the last member of the group.
+ * A listing in progress is cancelled by cancelFetch(), e.g. when the group is
+ * collapsed, or when another file is set.
+ *
+ * The HDF5 library is called from both the worker and the GUI thread. This requires
+ * a library built with thread-safety enabled (--enable-threadsafe), where the listing
+ * is done in slices, so that the library lock is held by the worker only for short
+ * periods. With other builds (see QH5File::isThreadSafe()) the members are listed
+ * on the GUI thread in fetchMore().
  *
  * If we assign the model to a view class, the structure of the file will be displayed.
  *
@@ -49,11 +67,18 @@ class QH5FileModel : public QAbstractItemModel
 {
     Q_OBJECT
 
+    friend class QH5GroupLister;
+
     void* rootNode;
 
     QH5File hdf5file;
+    QH5Group rootGroup;
     QFileIconProvider* iconProvider;
 
+    QThreadPool* worker;            // HDF5 worker thread for listing group members
+    quint64 lastRequest;
+    QHash<quint64, void*> loading;  // listing request id -> node
+
 public:
 
     enum { NumColumns = 1 };
@@ -86,9 +111,25 @@ public:
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
     // Fetch data dynamically:
+
+    /*!
+     * \brief Returns true if the group at parent has members
+     *
+     * For groups that have not been fetched yet this is known from the listing
+     * of their parent group, which reads the link count of each member group.
+     * A group whose links are all dangling or named datatypes, which are not
+     * shown by the model, thus returns true until it is fetched. HDF5 errors
+     * are reported with qWarning() and the group is shown without members.
+     */
     bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
 
+    /*!
+     * \brief Returns true if parent is a group whose members have not been read yet
+     */
     bool canFetchMore(const QModelIndex &parent) const override;
+    /*!
+     * \brief Read the members of the group at parent and insert them as rows
+     */
     void fetchMore(const QModelIndex &parent) override;
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
@@ -102,9 +143,38 @@ public:
      * This is usefull in code called in response to
      * item view signals, e.g., activated(const QModelIndex&), to
      * obtain a handle the HDF5 data associated with a given model index.
+     *
+     * The object is opened on demand by QH5File::group() or QH5File::dataset(),
+     * which keep the most recently used handles open.
      */
     QH5Node h5node(const QModelIndex &index) const;
 
+    /**
+     * @brief Maximum number of rows inserted at once while a group is loading
+     *
+     * Rows are also inserted when 16 ms have passed since the last batch.
+     * The default is 1000.
+     */
+    void setBatchSize(int n) { batchSize = qMax(1, n); }
+
+public slots:
+    /**
+     * @brief Cancel the listing of the group at parent, if it is in progress
+     *
+     * The rows loaded so far are removed, and the group is listed again
+     * by the next fetchMore(). Connect this slot to QTreeView::collapsed().
+     */
+    void cancelFetch(const QModelIndex& parent);
+
+private:
+    int batchSize;
+
+    QModelIndex nodeIndex(void* node) const;
+    void cancelTree(void* node);
+    void cancelAll();
+    void insertBatch(quint64 request, const QVector<QH5GroupEntry>& batch,
+                     const QVector<bool>& members, bool last);
+
 
 };
 
@@ -0,0 +1,302 @@
+#include "qh5chunkstats.h"
+
+#include <hdf5.h>
+
+#include <cstring>
+#include <limits>
+
+hid_t _h(const QH5id::h5id& id);
+hid_t _h(const QH5id& id);
+
+namespace {
+
+// elements per read in rebuild()
+const quint64 rebuildBlock = 1 << 20;
+
+QByteArray sidecarName(const char* name)
+{
+    return QByteArray(name) + ".chunkstats";
+}
+
+// chunk grid of the source at its current extent
+struct Grid
+{
+    QVector<quint64> dims, chunk, grid;
+    quint64 recSize;    // elements per record, i.e., per index of the 1st dimension
+    quint64 perRow;     // chunks per index of the 1st grid dimension
+
+    bool init(const QH5Dataset& ds)
+    {
+        dims = ds.dataspace().dimensions();
+        chunk = ds.createOptions().chunk();
+        if (dims.isEmpty() || chunk.size() != dims.size()) return false;
+
+        int r = dims.size();
+        grid.resize(r);
+        recSize = perRow = 1;
+        for(int i=0; i<r; ++i) {
+            grid[i] = (dims[i] + chunk[i] - 1) / chunk[i];
+            if (i) {
+                recSize *= dims[i];
+                perRow *= grid[i];
+            }
+        }
+        return recSize > 0;
+    }
+
+    quint64 count() const { return grid[0]*perRow; }
+
+    // chunk of the element at row-major position e
+    quint64 chunkOf(quint64 e) const
+    {
+        quint64 o = e % recSize, lin = 0, mult = 1;
+        for(int i=dims.size()-1; i>0; --i) {
+            lin += (o % dims[i]) / chunk[i] * mult;
+            o /= dims[i];
+            mult *= grid[i];
+        }
+        return e / recSize / chunk[0] * perRow + lin;
+    }
+};
+
+inline void accumulate(QH5ChunkStats::Entry& s, double v)
+{
+    s.count++;
+    if (v != v) {
+        s.nanCount++;
+        return;
+    }
+    if (v < s.min) s.min = v;
+    if (v > s.max) s.max = v;
+}
+
+inline void merge(QH5ChunkStats::Entry& s, const QH5ChunkStats::Entry& o)
+{
+    if (o.min < s.min) s.min = o.min;
+    if (o.max > s.max) s.max = o.max;
+    s.count += o.count;
+    s.nanCount += o.nanCount;
+}
+
+} // namespace
+
+QH5ChunkStats::Entry::Entry() : min(std::numeric_limits<double>::infinity()),
+    max(-std::numeric_limits<double>::infinity()), count(0), nanCount(0)
+{
+}
+
+QH5ChunkStats QH5ChunkStats::create(const QH5Group& g, const char* name)
+{
+    QH5ChunkStats st;
+    if (!g.isValid() || !g.isDataset(name)) return st;
+
+    QH5Dataset ds = g.openDataset(name);
+    QH5Datatype::Class cls = ds.datatype().getClass();
+    if (cls != QH5Datatype::INTEGER && cls != QH5Datatype::FLOAT) return st;
+    Grid grid;
+    if (!grid.init(ds)) return st;
+
+    QByteArray sname = sidecarName(name);
+    if (g.exists(sname)) {
+        herr_t ret = H5Ldelete(_h(g), sname.constData(), H5P_DEFAULT);
+        if (ret < 0) throw h5exception("Error in call to H5Ldelete");
+    }
+
+    QH5DatasetCreateOptions opt;
+    opt.setChunk({1024, 4});
+    st.stats_ = g.createDataset(sname,
+                                QH5Dataspace::extendible({0, 4}, {QH5Dataspace::UNLIMITED, 4}),
+                                QH5Datatype::fromValue(double()), opt);
+    if (!st.stats_.isValid()) return QH5ChunkStats();
+
+    st.ds_ = ds;
+    st.rebuild();
+    return st;
+}
+
+QH5ChunkStats QH5ChunkStats::open(const QH5Group& g, const char* name)
+{
+    QH5ChunkStats st;
+    QByteArray sname = sidecarName(name);
+    if (!g.isValid() || !g.isDataset(name) || !g.isDataset(sname)) return st;
+
+    st.ds_ = g.openDataset(name);
+    st.stats_ = g.openDataset(sname);
+    return st;
+}
+
+quint64 QH5ChunkStats::size() const
+{
+    return stats_.isValid() ? stats_.dataspace().dimensions()[0] : 0;
+}
+
+quint64 QH5ChunkStats::chunkCount() const
+{
+    Grid grid;
+    return grid.init(ds_) ? grid.count() : 0;
+}
+
+quint64 QH5ChunkStats::sourceElements() const
+{
+    quint64 n = 1;
+    foreach(quint64 d, ds_.dataspace().dimensions()) n *= d;
+    return n;
+}
+
+QVector<QH5ChunkStats::Entry> QH5ChunkStats::entries(quint64 first, quint64 n) const
+{
+    QVector<Entry> e;
+    quint64 stored = size();
+    if (first >= stored || !n) return e;
+    n = qMin(n, stored - first);
+
+    QH5Dataspace sel = stats_.dataspace();
+    sel.selectHyperslab({first, 0}, {n, 4});
+    QVector<double> v;
+    if (!stats_.read(v, sel)) return e;
+
+    e.resize(n);
+    for(quint64 i=0; i<n; ++i) {
+        e[i].min = v[4*i];
+        e[i].max = v[4*i+1];
+        e[i].count = quint64(v[4*i+2]);
+        e[i].nanCount = quint64(v[4*i+3]);
+    }
+    return e;
+}
+
+QVector<quint64> QH5ChunkStats::select(double lo, double hi) const
+{
+    QVector<quint64> chunks;
+    if (!isValid()) return chunks;
+
+    QVector<Entry> e = entries();
+    for(int i=0; i<e.size(); ++i)
+        if (e[i].overlaps(lo, hi)) chunks.push_back(i);
+
+    // no statistics yet, must be read
+    quint64 n = chunkCount();
+    for(quint64 i=e.size(); i<n; ++i) chunks.push_back(i);
+    return chunks;
+}
+
+QH5Dataspace QH5ChunkStats::chunkSelection(quint64 i) const
+{
+    Grid grid;
+    if (!grid.init(ds_) || i >= grid.count()) return QH5Dataspace();
+
+    int r = grid.dims.size();
+    QVector<quint64> offset(r), count(r);
+    quint64 rem = i % grid.perRow;
+    for(int d=r-1; d>=0; --d) {
+        quint64 c = d ? rem % grid.grid[d] : i / grid.perRow;
+        rem /= grid.grid[d];
+        offset[d] = c * grid.chunk[d];
+        count[d] = qMin(grid.chunk[d], grid.dims[d] - offset[d]);
+    }
+
+    QH5Dataspace sel = ds_.dataspace();
+    sel.selectHyperslab(offset, count);
+    return sel;
+}
+
+bool QH5ChunkStats::record(quint64 first, const void* data, quint64 n,
+                           const QH5Datatype& memtype) const
+{
+    if (!isValid() || !data) return false;
+    if (!n) return true;
+
+    QH5Datatype::Class cls = memtype.getClass();
+    if (cls != QH5Datatype::INTEGER && cls != QH5Datatype::FLOAT) return false;
+
+    if (H5Tequal(_h(memtype), H5T_NATIVE_DOUBLE) > 0)
+        return add_(first, static_cast<const double*>(data), n);
+
+    // convert in place to double
+    size_t sz = memtype.size();
+    QByteArray buf(int(n * qMax(sz, sizeof(double))), Qt::Uninitialized);
+    memcpy(buf.data(), data, n * sz);
+    herr_t ret = H5Tconvert(_h(memtype), H5T_NATIVE_DOUBLE, n, buf.data(), NULL, H5P_DEFAULT);
+    if (ret < 0) throw h5exception("Error in call to H5Tconvert");
+    return add_(first, reinterpret_cast<const double*>(buf.constData()), n);
+}
+
+bool QH5ChunkStats::add_(quint64 first, const double* v, quint64 n) const
+{
+    Grid grid;
+    if (!grid.init(ds_)) return false;
+
+    // all chunks of the touched rows of the chunk grid
+    quint64 rowLen = grid.chunk[0] * grid.recSize;
+    quint64 c0 = first / rowLen * grid.perRow;
+    quint64 c1 = (first + n - 1) / rowLen * grid.perRow + grid.perRow;
+
+    // chunks before c0 have no statistics, they were written without record()
+    quint64 stored = size();
+    if (c0 > stored) return false;
+
+    QVector<Entry> acc(c1 - c0);
+    if (grid.dims.size() == 1) {
+        quint64 e = first, end = first + n;
+        while (e < end) {
+            quint64 c = e / grid.chunk[0];
+            quint64 m = qMin((c + 1) * grid.chunk[0], end);
+            Entry& s = acc[c - c0];
+            for(; e < m; ++e) accumulate(s, v[e - first]);
+        }
+    } else {
+        for(quint64 i=0; i<n; ++i) accumulate(acc[grid.chunkOf(first + i) - c0], v[i]);
+    }
+
+    // merge with the partly filled chunks
+    if (c0 < stored) {
+        QVector<Entry> old = entries(c0, qMin(c1, stored) - c0);
+        for(int i=0; i<old.size(); ++i) merge(acc[i], old[i]);
+    }
+    if (c1 > stored && !stats_.setExtent({c1, 4})) return false;
+
+    QVector<double> rows(4 * acc.size());
+    for(int i=0; i<acc.size(); ++i) {
+        rows[4*i] = acc[i].min;
+        rows[4*i+1] = acc[i].max;
+        rows[4*i+2] = acc[i].count;
+        rows[4*i+3] = acc[i].nanCount;
+    }
+    QH5Dataspace sel = stats_.dataspace();
+    sel.selectHyperslab({c0, 0}, {c1 - c0, 4});
+    return stats_.write(rows, sel);
+}
+
+bool QH5ChunkStats::truncate(quint64 first) const
+{
+    if (!isValid()) return false;
+    Grid grid;
+    if (!grid.init(ds_)) return false;
+
+    quint64 c0 = first / (grid.chunk[0] * grid.recSize) * grid.perRow;
+    return c0 >= size() || stats_.setExtent({c0, 4});
+}
+
+bool QH5ChunkStats::rebuild() const
+{
+    if (!isValid()) return false;
+    Grid grid;
+    if (!grid.init(ds_)) return false;
+    if (!stats_.setExtent({0, 4})) return false;
+
+    // whole rows of chunks per read
+    quint64 rows = grid.chunk[0] * qMax<quint64>(1, rebuildBlock / (grid.chunk[0] * grid.recSize));
+    int r = grid.dims.size();
+    for(quint64 r0=0; r0<grid.dims[0]; r0+=rows) {
+        QVector<quint64> offset(r, 0), count(grid.dims);
+        offset[0] = r0;
+        count[0] = qMin(rows, grid.dims[0] - r0);
+
+        QH5Dataspace sel = ds_.dataspace();
+        sel.selectHyperslab(offset, count);
+        QVector<double> v;
+        if (!ds_.read(v, sel)) return false;
+        if (!add_(r0 * grid.recSize, v.constData(), v.size())) return false;
+    }
+    return true;
+}
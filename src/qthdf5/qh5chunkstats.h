@@ -0,0 +1,179 @@
+#ifndef QH5CHUNKSTATS_H
+#define QH5CHUNKSTATS_H
+
+#include "qthdf5.h"
+
+/**
+ * @brief Per-chunk statistics of a chunked numeric dataset
+ *
+ * QH5ChunkStats keeps the minimum, maximum, number of elements and number of NaNs
+ * of every chunk of a source dataset in a small sidecar dataset. Queries on the
+ * values of the source can then skip the chunks that cannot match without reading them.
+ *
+ * The sidecar is the dataset "<name>.chunkstats" next to the source, of shape
+ * (chunks, 4) with the columns min, max, count, nanCount as doubles.
+ * Entry i refers to chunk i of the source in row-major order of the chunk grid.
+ * The extent of the source may grow only along the first dimension.
+ *
+ * The statistics are computed when data is appended, from the data in
+ * memory: by append(), by a QH5StreamWriter with setChunkStats() or by calling
+ * record() after writing. rebuild() computes them again from the source, e.g.
+ * for an existing file or after data has been overwritten.
+ *
+ * \code
+ * QH5ChunkStats st = QH5ChunkStats::open(g, "ch7");
+ * if (!st.isValid()) st = QH5ChunkStats::create(g, "ch7"); // scans the dataset once
+ * QVector<double> v;
+ * foreach(quint64 c, st.select(threshold, qInf())) {
+ *     st.dataset().read(v, st.chunkSelection(c));
+ *     // ... find the samples > threshold in v
+ * }
+ * \endcode
+ *
+ * min and max do not include NaN values. They are +inf and -inf for a chunk
+ * without numbers.
+ *
+ */
+class HDF_EXPORT QH5ChunkStats
+{
+public:
+    /**
+     * @brief Statistics of a chunk
+     */
+    struct Entry {
+        double min;         //!< minimum of the non-NaN values
+        double max;         //!< maximum of the non-NaN values
+        quint64 count;      //!< number of elements, including NaN
+        quint64 nanCount;   //!< number of NaN elements
+
+        Entry();
+        /**
+         * @brief Returns true if the chunk may contain values in [lo, hi]
+         */
+        bool overlaps(double lo, double hi) const
+        { return count > nanCount && max >= lo && min <= hi; }
+    };
+
+    /**
+     * @brief Construct an invalid QH5ChunkStats
+     */
+    QH5ChunkStats() {}
+
+    /**
+     * @brief Create the statistics of dataset name in group g
+     *
+     * An existing sidecar is replaced. The statistics of the current data are
+     * computed with rebuild().
+     *
+     * @param g The group of the source dataset
+     * @param name The name of a chunked integer or floating point dataset in g
+     * @return QH5ChunkStats The statistics, invalid if the source is not supported
+     */
+    static QH5ChunkStats create(const QH5Group& g, const char* name);
+
+    /**
+     * @brief Open the existing statistics of dataset name in group g
+     *
+     * @return QH5ChunkStats The statistics, invalid if there is no sidecar
+     */
+    static QH5ChunkStats open(const QH5Group& g, const char* name);
+
+    /**
+     * @brief Returns true if the object refers to a source and its sidecar
+     */
+    bool isValid() const { return ds_.isValid() && stats_.isValid(); }
+
+    /**
+     * @brief Return the source dataset
+     */
+    const QH5Dataset& dataset() const { return ds_; }
+
+    /**
+     * @brief Number of chunks with statistics
+     */
+    quint64 size() const;
+
+    /**
+     * @brief Number of chunks of the source at its current extent
+     */
+    quint64 chunkCount() const;
+
+    /**
+     * @brief Read n entries starting at chunk first
+     */
+    QVector<Entry> entries(quint64 first = 0, quint64 n = ~quint64(0)) const;
+
+    /**
+     * @brief Chunks that may contain values in [lo, hi]
+     *
+     * Chunks of the source without statistics are always included.
+     *
+     * @return QVector<quint64> Indexes of the chunks in increasing order
+     */
+    QVector<quint64> select(double lo, double hi) const;
+
+    /**
+     * @brief A dataspace of the source with chunk i selected
+     */
+    QH5Dataspace chunkSelection(quint64 i) const;
+
+    /**
+     * @brief Add the statistics of n newly written elements
+     *
+     * The elements occupy the positions first ... first + n - 1 of the source
+     * in row-major order. They are merged into the entries of their chunks, so
+     * the same elements must not be recorded twice.
+     *
+     * @param first Position of the first element
+     * @param data Pointer to n elements
+     * @param n Number of elements
+     * @param memtype Datatype of the elements, an integer or floating point type
+     * @return true If succesfull
+     */
+    bool record(quint64 first, const void* data, quint64 n, const QH5Datatype& memtype) const;
+
+    /**
+     * @brief Remove the statistics from the chunk of element first on
+     *
+     * The entries of the whole row of the chunk grid that contains the element at
+     * row-major position first, and of all rows after it, are removed. These chunks
+     * then have no statistics and select() always returns them. Use it when
+     * the elements from first on could not be recorded.
+     *
+     * @return true If succesfull
+     */
+    bool truncate(quint64 first) const;
+
+    /**
+     * @brief Append n elements to the source and record their statistics
+     *
+     * See QH5Dataset::append(). Each call extends the source once and rewrites
+     * the entries of the touched chunks, so the elements should be passed in
+     * whole chunks where possible. For many small records use a QH5StreamWriter
+     * with QH5StreamWriter::setChunkStats(), which appends them in blocks.
+     */
+    template<typename T>
+    bool append(const T* data, quint64 n) const
+    {
+        if (!isValid()) return false;
+        quint64 first = sourceElements();
+        return ds_.append(data, n) &&
+                record(first, data, n, QH5Datatype::fromValue(*data));
+    }
+
+    /**
+     * @brief Compute the statistics of all chunks from the source
+     *
+     * @return true If succesfull
+     */
+    bool rebuild() const;
+
+private:
+    QH5Dataset ds_;
+    QH5Dataset stats_;
+
+    quint64 sourceElements() const;
+    bool add_(quint64 first, const double* v, quint64 n) const;
+};
+
+#endif // QH5CHUNKSTATS_H
@@ -0,0 +1,59 @@
+#include "qh5datasetwatcher.h"
+
+#include <QTimer>
+
+QH5DatasetWatcher::QH5DatasetWatcher(const QH5Dataset& ds, QObject* parent) :
+    QObject(parent), ds_(ds)
+{
+    timer_ = new QTimer(this);
+    timer_->setInterval(50);
+    connect(timer_, &QTimer::timeout, this, &QH5DatasetWatcher::check);
+    if (ds_.isValid()) dims_ = ds_.dataspace().dimensions();
+}
+
+void QH5DatasetWatcher::setInterval(int ms)
+{
+    timer_->setInterval(ms);
+}
+
+int QH5DatasetWatcher::interval() const
+{
+    return timer_->interval();
+}
+
+bool QH5DatasetWatcher::isActive() const
+{
+    return timer_->isActive();
+}
+
+void QH5DatasetWatcher::start()
+{
+    if (ds_.isValid()) timer_->start();
+}
+
+void QH5DatasetWatcher::stop()
+{
+    timer_->stop();
+}
+
+bool QH5DatasetWatcher::check()
+{
+    if (!ds_.isValid()) return false;
+
+    try {
+        ds_.refresh();
+        QVector<quint64> dims = ds_.dataspace().dimensions();
+        if (dims == dims_) return false;
+
+        QVector<quint64> old = dims_;
+        dims_ = dims;
+        emit extentChanged(dims_);
+        if (!old.isEmpty() && !dims_.isEmpty() && dims_[0] > old[0])
+            emit grown(old[0], dims_[0]);
+        return true;
+    }
+    catch (const h5exception&) {
+        // the writer may be in the middle of an update, try again later
+        return false;
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef QH5DATASETWATCHER_H
+#define QH5DATASETWATCHER_H
+
+#include "qthdf5.h"
+
+#include <QObject>
+
+class QTimer;
+
+/**
+ * @brief Watches a dataset for changes of its extent
+ *
+ * QH5DatasetWatcher is intended for readers of files opened in SWMR read mode
+ * (see QH5File::open()). It periodically calls QH5Dataset::refresh()
+ * and emits a signal when the dimensions of the dataset have changed.
+ *
+ * \code
+ * QH5File f("daq.h5");
+ * f.open(QIODevice::ReadOnly, true); // SWMR read
+ * QH5DatasetWatcher* w = new QH5DatasetWatcher(f.root().openDataset("adc"), this);
+ * connect(w, &QH5DatasetWatcher::grown, this, &Viewer::readNewSamples);
+ * w->start();
+ * \endcode
+ *
+ * The watcher lives in the thread that created it and calls HDF5 from there.
+ *
+ */
+class HDF_EXPORT QH5DatasetWatcher : public QObject
+{
+    Q_OBJECT
+
+    QH5Dataset ds_;
+    QVector<quint64> dims_;
+    QTimer* timer_;
+
+public:
+    /**
+     * @brief Construct a new QH5DatasetWatcher object
+     *
+     * @param ds The dataset to watch
+     * @param parent Parent QObject
+     */
+    explicit QH5DatasetWatcher(const QH5Dataset& ds, QObject* parent = nullptr);
+
+    /**
+     * @brief Set the polling interval in ms. The default is 50 ms.
+     */
+    void setInterval(int ms);
+    /**
+     * @brief Return the polling interval in ms
+     */
+    int interval() const;
+
+    /**
+     * @brief Return the dataset dimensions found at the last check
+     */
+    const QVector<quint64>& dimensions() const { return dims_; }
+
+    /**
+     * @brief Return the watched dataset
+     */
+    const QH5Dataset& dataset() const { return ds_; }
+
+    /**
+     * @brief Returns true if polling is active
+     */
+    bool isActive() const;
+
+public slots:
+    /**
+     * @brief Start polling
+     */
+    void start();
+    /**
+     * @brief Stop polling
+     */
+    void stop();
+    /**
+     * @brief Refresh the dataset and check its dimensions
+     *
+     * Called at each polling interval. Can also be called directly.
+     *
+     * @return true If the dimensions have changed
+     */
+    bool check();
+
+signals:
+    /**
+     * @brief Emitted when the dimensions of the dataset have changed
+     */
+    void extentChanged(const QVector<quint64>& dims);
+    /**
+     * @brief Emitted when the first dimension of the dataset has grown
+     *
+     * @param from The previous size of the first dimension
+     * @param to The new size
+     */
+    void grown(quint64 from, quint64 to);
+};
+
+#endif // QH5DATASETWATCHER_H
@@ -0,0 +1,188 @@
+#include "qh5fileindex.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+
+QByteArray _normalizedPath(const QByteArray& path);
+
+namespace {
+
+const quint32 sidecarMagic = 0x51354958; // "Q5IX"
+const quint32 sidecarVersion = 1;
+
+// shape, datatype and storage size of a dataset
+void readDetails(const QH5Group& root, QH5FileIndex::Entry& e)
+{
+    QH5Dataset ds = root.openDataset(e.path);
+    if (!ds.isValid()) return;
+
+    e.shape = ds.dataspace().dimensions();
+    QH5Datatype t = ds.datatype();
+    e.dtypeClass = t.getClass();
+    e.dtypeSize = quint32(t.size());
+    e.storageSize = ds.storageSize();
+}
+
+} // namespace
+
+QDataStream& operator<<(QDataStream& s, const QH5FileIndex::Entry& e)
+{
+    return s << e.path << quint8(e.type) << e.address << e.ctime << e.shape
+             << quint8(e.dtypeClass) << e.dtypeSize << e.storageSize;
+}
+
+QDataStream& operator>>(QDataStream& s, QH5FileIndex::Entry& e)
+{
+    quint8 type, cls;
+    s >> e.path >> type >> e.address >> e.ctime >> e.shape
+      >> cls >> e.dtypeSize >> e.storageSize;
+    e.type = QH5Node::Type(type);
+    e.dtypeClass = QH5Datatype::Class(cls);
+    return s;
+}
+
+QH5FileIndex::QH5FileIndex(const QString& fname) : fname_(fname),
+    fileSize_(-1), fileTime_(-1), buildTime_(0), readCount_(0)
+{
+}
+
+bool QH5FileIndex::fileStamp(qint64& size, qint64& time) const
+{
+    QFileInfo fi(fname_);
+    if (!fi.exists()) return false;
+    size = fi.size();
+    time = fi.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+bool QH5FileIndex::isValid() const
+{
+    qint64 size, time;
+    return fileStamp(size, time) && size == fileSize_ && time == fileTime_;
+}
+
+void QH5FileIndex::clear()
+{
+    entries_.clear();
+    byPath_.clear();
+    children_.clear();
+    fileSize_ = fileTime_ = -1;
+    buildTime_ = 0;
+}
+
+void QH5FileIndex::rehash()
+{
+    byPath_.clear();
+    children_.clear();
+    byPath_.reserve(entries_.size());
+    for(int i=0; i<entries_.size(); ++i) {
+        const QByteArray& p = entries_[i].path;
+        byPath_.insert(p, i);
+        int k = p.lastIndexOf('/');
+        children_[k < 0 ? QByteArray() : p.left(k)].push_back(i);
+    }
+}
+
+bool QH5FileIndex::load()
+{
+    clear();
+
+    QFile f(sidecarName(fname_));
+    if (!f.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    s >> magic >> version;
+    if (magic != sidecarMagic || version != sidecarVersion) return false;
+
+    s >> fileSize_ >> fileTime_ >> buildTime_ >> entries_;
+    if (s.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    rehash();
+    return isValid();
+}
+
+bool QH5FileIndex::save() const
+{
+    QSaveFile f(sidecarName(fname_));
+    if (!f.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_0);
+    s << sidecarMagic << sidecarVersion
+      << fileSize_ << fileTime_ << buildTime_ << entries_;
+
+    return s.status() == QDataStream::Ok && f.commit();
+}
+
+bool QH5FileIndex::update(const QH5File& file, bool full)
+{
+    if (!file.isOpen() || file.fileName() != fname_) return false;
+
+    QH5Group root = file.root();
+    // changes in the current second may go unnoticed by the next update,
+    // see the ctime comparison below
+    qint64 start = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    QVector<Entry> entries;
+    entries.reserve(entries_.size());
+    int readCount = 0;
+
+    root.visit([&](const QH5VisitEntry& v) {
+        Entry e;
+        e.path = v.path;
+        e.type = v.type;
+        e.address = v.address;
+        e.ctime = v.ctime;
+
+        if (e.type == QH5Node::DATASET) {
+            // reuse the details if the object header did not change since the last build
+            const Entry* prev = 0;
+            if (!full && e.ctime && e.ctime < buildTime_) {
+                QHash<QByteArray, int>::const_iterator i = byPath_.constFind(e.path);
+                if (i != byPath_.constEnd()) prev = &entries_.at(i.value());
+            }
+            if (prev && prev->type == e.type && prev->address == e.address && prev->ctime == e.ctime) {
+                e.shape = prev->shape;
+                e.dtypeClass = prev->dtypeClass;
+                e.dtypeSize = prev->dtypeSize;
+                e.storageSize = prev->storageSize;
+            } else {
+                readDetails(root, e);
+                readCount++;
+            }
+        }
+
+        entries.push_back(e);
+        return true;
+    });
+
+    // the on-disk size and time are final only after a flush
+    if (!file.isInMemory()) file.flush();
+
+    entries_.swap(entries);
+    readCount_ = readCount;
+    buildTime_ = start;
+    rehash();
+    if (!fileStamp(fileSize_, fileTime_)) return true; // e.g. an in-memory file
+    save();
+    return true;
+}
+
+const QH5FileIndex::Entry* QH5FileIndex::find(const QByteArray& path) const
+{
+    QHash<QByteArray, int>::const_iterator i = byPath_.constFind(_normalizedPath(path));
+    return i == byPath_.constEnd() ? 0 : &entries_.at(i.value());
+}
+
+QVector<int> QH5FileIndex::children(const QByteArray& path) const
+{
+    return children_.value(_normalizedPath(path));
+}
@@ -0,0 +1,168 @@
+#ifndef QH5FILEINDEX_H
+#define QH5FILEINDEX_H
+
+#include "qthdf5.h"
+
+#include <QHash>
+
+/**
+ * @brief Persistent index of the structure of a HDF5 file
+ *
+ * QH5FileIndex holds the path, type, shape, datatype and storage size of all
+ * objects in a HDF5 file. It is kept in a sidecar file next to the HDF5 file
+ * (see sidecarName()), so that the structure of a large file is available
+ * when it is re-opened without reading its object headers.
+ *
+ * The sidecar records the size and modification time of the HDF5 file. If they
+ * no longer match, the index is stale and update() rebuilds it incrementally:
+ * the hierarchy is traversed once with QH5Group::visit() and only datasets that
+ * have been created or modified since the last build are opened to get their
+ * details.
+ *
+ * \code
+ * QH5File h5f("archive.h5");
+ * h5f.open(QIODevice::ReadOnly);
+ * QH5FileIndex idx(h5f.fileName());
+ * if (!idx.load()) idx.update(h5f); // rebuild and save when missing or stale
+ * foreach(int i, idx.children("run42")) qDebug() << idx.at(i).path;
+ * \endcode
+ *
+ * Modification of the object headers is detected from the object change
+ * times, which HDF5 records with one second resolution by default
+ * (H5Pset_obj_track_times). For objects without recorded times the details are
+ * always re-read. Writing raw data to an allocated dataset does not change
+ * its header, so the storage size of such a dataset is refreshed only by a
+ * full rebuild.
+ *
+ * Paths are relative to the root group, without a leading '/'. The
+ * root group itself is not an entry of the index.
+ *
+ */
+class HDF_EXPORT QH5FileIndex
+{
+public:
+    /**
+     * @brief Information on a HDF5 object stored in the index
+     */
+    struct Entry {
+        QByteArray path;            //!< path relative to the root group
+        QH5Node::Type type;         //!< object type
+        quint64 address;            //!< object address in the file
+        qint64 ctime;               //!< object header change time in s since the epoch, 0 if not tracked
+        QVector<quint64> shape;     //!< dataset dimensions
+        QH5Datatype::Class dtypeClass; //!< dataset datatype class
+        quint32 dtypeSize;          //!< dataset datatype size in bytes
+        quint64 storageSize;        //!< dataset storage size in the file in bytes
+
+        Entry() : type(QH5Node::UNKNOWN), address(0), ctime(0),
+            dtypeClass(QH5Datatype::UNSUPPORTED), dtypeSize(0), storageSize(0) {}
+
+        /**
+         * @brief Name of the object, the last component of the path
+         */
+        QByteArray name() const { return path.mid(path.lastIndexOf('/') + 1); }
+    };
+
+    /**
+     * @brief Construct an index for the HDF5 file fname
+     */
+    explicit QH5FileIndex(const QString& fname = QString());
+
+    /**
+     * @brief Name of the sidecar file for the HDF5 file fname, fname + ".qh5idx"
+     */
+    static QString sidecarName(const QString& fname) { return fname + ".qh5idx"; }
+
+    /**
+     * @brief Name of the HDF5 file
+     */
+    const QString& fileName() const { return fname_; }
+
+    /**
+     * @brief Read the index from the sidecar file
+     *
+     * The entries are loaded even if the index is stale, so that a following
+     * update() can rebuild it incrementally.
+     *
+     * @return true If the sidecar was read and matches the HDF5 file
+     * @return false If the sidecar is missing, invalid or stale
+     */
+    bool load();
+
+    /**
+     * @brief Write the index to the sidecar file
+     *
+     * @return true If succesfull
+     */
+    bool save() const;
+
+    /**
+     * @brief Bring the index up to date with the open HDF5 file and save it
+     *
+     * @param file The HDF5 file, opened with the same name as this index
+     * @param full If true all dataset details are re-read, otherwise only those
+     *      of datasets changed since the last build
+     * @return true If the index was built. It is kept in memory even if
+     *      it could not be saved.
+     */
+    bool update(const QH5File& file, bool full = false);
+
+    /**
+     * @brief Returns true if the index matches the current size and modification time of the HDF5 file
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Remove all entries
+     */
+    void clear();
+
+    /**
+     * @brief Number of entries
+     */
+    int size() const { return entries_.size(); }
+
+    /**
+     * @brief Entry i, 0 <= i < size()
+     */
+    const Entry& at(int i) const { return entries_.at(i); }
+
+    /**
+     * @brief All entries, parents before their members
+     */
+    const QVector<Entry>& entries() const { return entries_; }
+
+    /**
+     * @brief Find the entry for path
+     *
+     * @return const Entry* The entry, or 0 if path is not in the index
+     */
+    const Entry* find(const QByteArray& path) const;
+
+    /**
+     * @brief Indexes of the entries that are direct members of group path
+     *
+     * An empty path denotes the root group.
+     */
+    QVector<int> children(const QByteArray& path) const;
+
+    /**
+     * @brief Number of datasets re-read by the last update()
+     */
+    int lastUpdateReadCount() const { return readCount_; }
+
+private:
+    QString fname_;
+    QVector<Entry> entries_;
+    QHash<QByteArray, int> byPath_;
+    QHash<QByteArray, QVector<int> > children_;
+    qint64 fileSize_;       // size of the HDF5 file when the index was built
+    qint64 fileTime_;       // modification time in ms of the HDF5 file when the index was built
+    qint64 buildTime_;      // time in s when the last build started
+    int readCount_;
+
+    void rehash();
+    bool fileStamp(qint64& size, qint64& time) const;
+};
+
+#endif // QH5FILEINDEX_H
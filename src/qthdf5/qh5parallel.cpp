@@ -0,0 +1,500 @@
+#include "qthdf5.h"
+
+#include <hdf5.h>
+#include <zlib.h>
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <cstring>
+
+// defined in qthdf5.cpp
+hid_t _h(const QH5id::h5id& v);
+hid_t _h(const QH5id& v);
+
+namespace {
+
+/*
+ * The filter pipeline of a dataset, as far as it can be
+ * reproduced outside of HDF5
+ */
+struct ChunkPipeline
+{
+    bool supported;
+    bool shuffle;
+    int deflate; // compression level, -1 = no deflate
+    quint32 shuffleMask; // bit of each filter in the chunk filter mask
+    quint32 deflateMask;
+
+    explicit ChunkPipeline(hid_t dcpl) : supported(true), shuffle(false), deflate(-1),
+        shuffleMask(0), deflateMask(0)
+    {
+        int n = H5Pget_nfilters(dcpl);
+        if (n < 0) throw h5exception("Error in call to H5Pget_nfilters");
+        for(int i=0; i<n; ++i) {
+            unsigned flags, cd[8];
+            size_t ncd = 8;
+            H5Z_filter_t f = H5Pget_filter2(dcpl, i, &flags, &ncd, cd, 0, 0, 0);
+            if (f == H5Z_FILTER_SHUFFLE && deflate < 0) {
+                shuffle = true;
+                shuffleMask = 1u << i;
+            } else if (f == H5Z_FILTER_DEFLATE && ncd > 0) {
+                deflate = cd[0];
+                deflateMask = 1u << i;
+            }
+            else supported = false;
+        }
+    }
+};
+
+/*
+ * Largest chunk in bytes handled by the parallel paths. The chunk and its
+ * compressBound() must fit in a QByteArray, larger chunks go through HDF5.
+ */
+const quint64 maxChunkBytes = quint64(1) << 30;
+
+quint64 chunkBytes(const QH5Datatype& ftype, const QVector<quint64>& chunk)
+{
+    quint64 n = ftype.size();
+    for(int i=0; i<chunk.size(); ++i) n *= chunk[i];
+    return n;
+}
+
+/*
+ * Return a chunk of the dataset filled with the fill value,
+ * chunkBytes() must not exceed maxChunkBytes
+ */
+QByteArray fillChunk(hid_t dcpl, const QH5Datatype& ftype, const QVector<quint64>& chunk)
+{
+    size_t typeSize = ftype.size();
+    quint64 n = 1;
+    for(int i=0; i<chunk.size(); ++i) n *= chunk[i];
+    QByteArray buff(int(n*typeSize), '\0');
+    QByteArray fv(int(typeSize), '\0');
+    if (H5Pget_fill_value(dcpl, _h(ftype), fv.data()) >= 0)
+        for(quint64 i=0; i<n; ++i)
+            memcpy(buff.data() + i*typeSize, fv.constData(), typeSize);
+    return buff;
+}
+
+void shuffle(const char* src, char* dst, size_t nbytes, size_t typeSize)
+{
+    size_t n = nbytes / typeSize;
+    for(size_t j=0; j<typeSize; ++j)
+        for(size_t i=0; i<n; ++i)
+            dst[j*n + i] = src[i*typeSize + j];
+}
+void unshuffle(const char* src, char* dst, size_t nbytes, size_t typeSize)
+{
+    size_t n = nbytes / typeSize;
+    for(size_t j=0; j<typeSize; ++j)
+        for(size_t i=0; i<n; ++i)
+            dst[i*typeSize + j] = src[j*n + i];
+}
+
+/*
+ * Copy the box of elements with origin lo and size count between
+ * two row-major arrays.
+ *
+ * Each array is given by its origin and dimensions in
+ * dataset coordinates.
+ */
+struct ArrayBox
+{
+    char* data;
+    QVector<quint64> origin;
+    QVector<quint64> dims;
+};
+void copyBox(const ArrayBox& dst, const ArrayBox& src,
+             const QVector<quint64>& lo, const QVector<quint64>& count, size_t typeSize)
+{
+    int rank = lo.size();
+    const size_t run = count[rank-1]*typeSize;
+
+    QVector<quint64> idx(rank, 0);
+    forever {
+        quint64 so = 0, d = 0;
+        for(int k=0; k<rank; ++k) {
+            so = so*src.dims[k] + (lo[k] + idx[k] - src.origin[k]);
+            d = d*dst.dims[k] + (lo[k] + idx[k] - dst.origin[k]);
+        }
+        memcpy(dst.data + d*typeSize, src.data + so*typeSize, run);
+
+        int k = rank-2;
+        for(; k>=0; --k) {
+            if (++idx[k] < count[k]) break;
+            idx[k] = 0;
+        }
+        if (k < 0) break;
+    }
+}
+
+/*
+ * Split the dataset in its chunk grid
+ */
+struct ChunkGrid
+{
+    QVector<quint64> dims;
+    QVector<quint64> chunk;
+    QVector<quint64> n; // chunks per dimension
+    quint64 total;
+
+    ChunkGrid(const QVector<quint64>& d, const QVector<quint64>& c) :
+        dims(d), chunk(c), n(d.size()), total(1)
+    {
+        for(int i=0; i<d.size(); ++i) {
+            n[i] = (d[i] + c[i] - 1)/c[i];
+            total *= n[i];
+        }
+    }
+
+    // offset of the i-th chunk in row-major order
+    QVector<quint64> offset(quint64 i) const
+    {
+        QVector<quint64> o(dims.size());
+        for(int k=dims.size()-1; k>=0; --k) {
+            o[k] = (i % n[k])*chunk[k];
+            i /= n[k];
+        }
+        return o;
+    }
+
+    // number of elements of the chunk at offset o within the extent
+    QVector<quint64> count(const QVector<quint64>& o) const
+    {
+        QVector<quint64> c(dims.size());
+        for(int k=0; k<dims.size(); ++k) c[k] = qMin(chunk[k], dims[k] - o[k]);
+        return c;
+    }
+};
+
+struct ChunkSlot
+{
+    QVector<quint64> offset;
+    QByteArray data;
+    bool ready;
+    bool ok;
+};
+
+/*
+ * Shared state between the writing thread and the compression tasks
+ */
+struct ParallelWrite
+{
+    const ChunkGrid* grid;
+    const ChunkPipeline* pipeline;
+    const char* src;
+    size_t typeSize;
+    QByteArray fill; // chunk filled with the fill value
+
+    QMutex mutex;
+    QWaitCondition done;
+    int pending;
+
+    void wait()
+    {
+        QMutexLocker lock(&mutex);
+        while (pending) done.wait(&mutex);
+    }
+};
+
+class ChunkCompressTask : public QRunnable
+{
+    ParallelWrite* w_;
+    ChunkSlot* slot_;
+public:
+    ChunkCompressTask(ParallelWrite* w, ChunkSlot* s) : w_(w), slot_(s) {}
+
+    void run() override
+    {
+        bool ok = compress();
+        QMutexLocker lock(&w_->mutex);
+        slot_->ok = ok;
+        slot_->ready = true;
+        w_->pending--;
+        w_->done.wakeAll();
+    }
+
+private:
+    bool compress()
+    {
+        const ChunkGrid& g = *w_->grid;
+
+        // gather the chunk from the source array
+        QByteArray raw(w_->fill);
+        ArrayBox dst = { raw.data(), slot_->offset, g.chunk };
+        ArrayBox src = { const_cast<char*>(w_->src), QVector<quint64>(g.dims.size(), 0), g.dims };
+        copyBox(dst, src, slot_->offset, g.count(slot_->offset), w_->typeSize);
+
+        if (w_->pipeline->shuffle && w_->typeSize > 1) {
+            QByteArray tmp(raw.size(), Qt::Uninitialized);
+            shuffle(raw.constData(), tmp.data(), raw.size(), w_->typeSize);
+            raw.swap(tmp);
+        }
+
+        if (w_->pipeline->deflate < 0) {
+            slot_->data = raw;
+            return true;
+        }
+
+        uLongf n = compressBound(raw.size());
+        slot_->data.resize(n);
+        int ret = compress2(reinterpret_cast<Bytef*>(slot_->data.data()), &n,
+                            reinterpret_cast<const Bytef*>(raw.constData()), raw.size(),
+                            w_->pipeline->deflate);
+        if (ret != Z_OK) return false;
+        slot_->data.resize(n);
+        return true;
+    }
+};
+
+/*
+ * Shared state between the reading thread and the decompression tasks
+ */
+struct ParallelRead
+{
+    const ChunkGrid* grid;
+    const ChunkPipeline* pipeline;
+    ArrayBox dst; // the selected block in the caller's buffer
+    size_t typeSize;
+    QByteArray fill;
+
+    QMutex mutex;
+    QWaitCondition done;
+    int pending;
+    bool error;
+
+    void wait(int maxPending)
+    {
+        QMutexLocker lock(&mutex);
+        while (pending > maxPending) done.wait(&mutex);
+    }
+};
+
+class ChunkDecompressTask : public QRunnable
+{
+    ParallelRead* r_;
+    QVector<quint64> offset_;
+    QByteArray data_; // raw chunk, empty if not allocated
+    quint32 mask_;
+public:
+    ChunkDecompressTask(ParallelRead* r, const QVector<quint64>& offset,
+                        const QByteArray& data, quint32 mask) :
+        r_(r), offset_(offset), data_(data), mask_(mask) {}
+
+    void run() override
+    {
+        bool ok = decompress();
+        QMutexLocker lock(&r_->mutex);
+        if (!ok) r_->error = true;
+        r_->pending--;
+        r_->done.wakeAll();
+    }
+
+private:
+    bool decompress()
+    {
+        const ChunkGrid& g = *r_->grid;
+        const ChunkPipeline& p = *r_->pipeline;
+        const int nbytes = r_->fill.size();
+
+        QByteArray raw;
+        if (data_.isEmpty()) raw = r_->fill;
+        else if (p.deflate >= 0 && !(mask_ & p.deflateMask)) {
+            raw.resize(nbytes);
+            uLongf n = nbytes;
+            int ret = uncompress(reinterpret_cast<Bytef*>(raw.data()), &n,
+                                 reinterpret_cast<const Bytef*>(data_.constData()), data_.size());
+            if (ret != Z_OK || int(n) != nbytes) return false;
+        }
+        else raw = data_;
+        if (raw.size() != nbytes) return false;
+
+        if (!data_.isEmpty() && p.shuffle && !(mask_ & p.shuffleMask) && r_->typeSize > 1) {
+            QByteArray tmp(nbytes, Qt::Uninitialized);
+            unshuffle(raw.constData(), tmp.data(), nbytes, r_->typeSize);
+            raw.swap(tmp);
+        }
+
+        // copy the intersection of the chunk and the selected block
+        const ArrayBox& dst = r_->dst;
+        QVector<quint64> lo(g.dims.size()), count(g.dims.size());
+        for(int k=0; k<lo.size(); ++k) {
+            lo[k] = qMax(offset_[k], dst.origin[k]);
+            count[k] = qMin(offset_[k] + g.chunk[k], dst.origin[k] + dst.dims[k]) - lo[k];
+        }
+        ArrayBox src = { raw.data(), offset_, g.chunk };
+        copyBox(dst, src, lo, count, r_->typeSize);
+        return true;
+    }
+};
+
+} // namespace
+
+bool QH5Dataset::writeParallel_(const void* data, const QH5Dataspace& memspace,
+                                const QH5Datatype& memtype, QThreadPool* pool) const
+{
+    if (!data || !memspace.isValid() || !memtype.isValid() || !isValid()) return false;
+
+    QH5Dataspace fspace = dataspace();
+    // size() is an int, the dataset may have more than 2^31 elements
+    if (memspace.selectionSize() != fspace.selectionSize()) return false;
+
+    hid_t dcpl = H5Dget_create_plist(_h(id_));
+    if (dcpl < 0) throw h5exception("Error in call to H5Dget_create_plist");
+    QH5id plist(static_cast<h5id>(dcpl), false);
+
+    // check that the chunks can be produced without HDF5
+    QH5Datatype ftype = datatype();
+    ChunkPipeline pipeline(dcpl);
+    if (!H5_VERSION_GE(1,10,5) || H5Pget_layout(dcpl) != H5D_CHUNKED ||
+            !pipeline.supported || pipeline.deflate < 0 ||
+            H5Tequal(_h(ftype), _h(memtype)) <= 0 ||
+            chunkBytes(ftype, createOptions().chunk()) > maxChunkBytes)
+        return write_(data, memspace, memtype);
+
+    ChunkGrid grid(fspace.dimensions(), createOptions().chunk());
+    if (grid.total == 0) return true;
+
+    if (!pool) pool = QThreadPool::globalInstance();
+
+    ParallelWrite w;
+    w.grid = &grid;
+    w.pipeline = &pipeline;
+    w.src = static_cast<const char*>(data);
+    w.typeSize = ftype.size();
+    w.pending = 0;
+
+    // the edge chunks are padded with the fill value, as by H5Dwrite
+    w.fill = fillChunk(dcpl, ftype, grid.chunk);
+
+    // a window of 2 chunks per thread is compressed ahead of the writes
+    const quint64 window = qMax(2, 2*pool->maxThreadCount());
+    QVector<ChunkSlot> ring(int(qMin(window, grid.total)));
+
+    quint64 submitted = 0, committed = 0;
+    bool ok = true;
+    try {
+        while (ok && committed < grid.total) {
+
+            while (submitted < grid.total && submitted - committed < quint64(ring.size())) {
+                ChunkSlot& s = ring[int(submitted % ring.size())];
+                s.offset = grid.offset(submitted);
+                s.ready = false;
+                {
+                    QMutexLocker lock(&w.mutex);
+                    w.pending++;
+                }
+                pool->start(new ChunkCompressTask(&w, &s));
+                submitted++;
+            }
+
+            ChunkSlot& s = ring[int(committed % ring.size())];
+            {
+                QMutexLocker lock(&w.mutex);
+                while (!s.ready) w.done.wait(&w.mutex);
+            }
+
+            ok = s.ok && writeChunk(s.offset, 0, s.data);
+            committed++;
+        }
+    }
+    catch (...) {
+        // the tasks refer to local data
+        w.wait();
+        throw;
+    }
+
+    w.wait();
+    return ok;
+}
+
+bool QH5Dataset::readParallel_(void* data, const QH5Dataspace& memspace,
+                               const QH5Datatype& memtype, const QH5Dataspace& filespace,
+                               QThreadPool* pool) const
+{
+    if (!data || !memspace.isValid() || !memtype.isValid() ||
+            !filespace.isValid() || !isValid()) return false;
+    if (filespace.selectionSize() != memspace.selectionSize()) return false;
+    if (filespace.selectionSize() == 0) return true;
+
+    hid_t dcpl = H5Dget_create_plist(_h(id_));
+    if (dcpl < 0) throw h5exception("Error in call to H5Dget_create_plist");
+    QH5id plist(static_cast<h5id>(dcpl), false);
+
+    // the selection must be a single block
+    QVector<quint64> start, end;
+    quint64 n = 1;
+    bool block = filespace.selectionBounds(start, end);
+    for(int i=0; block && i<start.size(); ++i) n *= end[i] - start[i] + 1;
+    block = block && n == filespace.selectionSize();
+
+    QH5Datatype ftype = datatype();
+    ChunkPipeline pipeline(dcpl);
+    if (!H5_VERSION_GE(1,10,5) || !block || H5Pget_layout(dcpl) != H5D_CHUNKED ||
+            !pipeline.supported || H5Tequal(_h(ftype), _h(memtype)) <= 0 ||
+            chunkBytes(ftype, createOptions().chunk()) > maxChunkBytes)
+        return read_(data, memspace, memtype, filespace);
+
+    ChunkGrid grid(dataspace().dimensions(), createOptions().chunk());
+
+    if (!pool) pool = QThreadPool::globalInstance();
+
+    ParallelRead r;
+    r.grid = &grid;
+    r.pipeline = &pipeline;
+    r.dst.data = static_cast<char*>(data);
+    r.dst.origin = start;
+    r.dst.dims.resize(start.size());
+    for(int i=0; i<start.size(); ++i) r.dst.dims[i] = end[i] - start[i] + 1;
+    r.typeSize = ftype.size();
+    r.fill = fillChunk(dcpl, ftype, grid.chunk);
+    r.pending = 0;
+    r.error = false;
+
+    // the chunks intersecting the block
+    const int rank = start.size();
+    QVector<quint64> first(rank), last(rank), idx(rank);
+    for(int k=0; k<rank; ++k) {
+        first[k] = start[k]/grid.chunk[k];
+        last[k] = end[k]/grid.chunk[k];
+    }
+    idx = first;
+
+    const int window = qMax(2, 2*pool->maxThreadCount());
+    try {
+        forever {
+            QVector<quint64> offset(rank);
+            for(int k=0; k<rank; ++k) offset[k] = idx[k]*grid.chunk[k];
+
+            // raw reads are done here, HDF5 calls are serialized anyway
+            quint32 mask = 0;
+            QByteArray raw = readChunk(offset, &mask);
+
+            r.wait(window-1);
+            {
+                QMutexLocker lock(&r.mutex);
+                if (r.error) break;
+                r.pending++;
+            }
+            pool->start(new ChunkDecompressTask(&r, offset, raw, mask));
+
+            int k = rank-1;
+            for(; k>=0; --k) {
+                if (++idx[k] <= last[k]) break;
+                idx[k] = first[k];
+            }
+            if (k < 0) break;
+        }
+    }
+    catch (...) {
+        // the tasks refer to local data
+        r.wait(0);
+        throw;
+    }
+
+    r.wait(0);
+    return !r.error;
+}
@@ -0,0 +1,280 @@
+#include "qh5pyramid.h"
+
+#include <hdf5.h>
+
+#include <limits>
+
+hid_t _h(const QH5id::h5id& id);
+hid_t _h(const QH5id& id);
+
+namespace {
+
+// bins per read or write in update()
+const quint64 updateBlock = 4096;
+
+QByteArray levelName(int k)
+{
+    return QByteArray("L") + QByteArray::number(k);
+}
+
+QByteArray lodName(const char* name)
+{
+    return QByteArray(name) + ".lod";
+}
+
+// rows r0 ... r0 + n - 1 of a level, 3 values per row
+QVector<double> readRows(const QH5Dataset& level, quint64 r0, quint64 n)
+{
+    QVector<double> v;
+    if (!n) return v;
+    QH5Dataspace sel = level.dataspace();
+    sel.selectHyperslab({r0, 0}, {n, 3});
+    level.read(v, sel);
+    return v;
+}
+
+// samples s0 ... s0 + n - 1 of the source as double
+QVector<double> readSamples(const QH5Dataset& ds, quint64 s0, quint64 n)
+{
+    QVector<double> v;
+    if (!n) return v;
+    QH5Dataspace sel = ds.dataspace();
+    sel.selectHyperslab({s0}, {n});
+    ds.read(v, sel);
+    return v;
+}
+
+} // namespace
+
+// running summary of a bin
+struct QH5Pyramid::Acc
+{
+    double min, max, sum;
+    quint64 n;
+
+    Acc() : min(0), max(0), sum(0), n(0) {}
+    // a NaN mean denotes a bin with only NaN samples, which is empty
+    Acc(double mn, double mx, double mean, quint64 cnt) :
+        min(mn), max(mx), sum(mean*cnt), n(mean != mean ? 0 : cnt) {}
+
+    void add(const Acc& o)
+    {
+        if (!o.n) return;
+        if (!n) { *this = o; return; }
+        if (o.min < min) min = o.min;
+        if (o.max > max) max = o.max;
+        sum += o.sum;
+        n += o.n;
+    }
+};
+
+QH5Pyramid QH5Pyramid::create(const QH5Group& g, const char* name,
+                              int minBinSize, int levels)
+{
+    QH5Pyramid p;
+    if (!g.isValid() || minBinSize < 1 || levels < 1 || levels > 48) return p;
+    if (!g.isDataset(name)) return p;
+
+    QH5Dataset ds = g.openDataset(name);
+    QH5Datatype::Class cls = ds.datatype().getClass();
+    if (ds.dataspace().rank() != 1 ||
+            (cls != QH5Datatype::INTEGER && cls != QH5Datatype::FLOAT)) return p;
+
+    QByteArray gname = lodName(name);
+    if (g.exists(gname)) {
+        herr_t ret = H5Ldelete(_h(g), gname.constData(), H5P_DEFAULT);
+        if (ret < 0) throw h5exception("Error in call to H5Ldelete");
+    }
+    QH5Group lod = g.createGroup(gname);
+    if (!lod.isValid()) return p;
+
+    quint64 bin = 1;
+    while (bin < quint64(minBinSize)) bin <<= 1;
+    lod.writeAttribute("minBinSize", bin);
+
+    QH5DatasetCreateOptions opt;
+    opt.setChunk({1024, 3});
+    for(int k=0; k<levels; ++k) {
+        QH5Dataset level = lod.createDataset(levelName(k),
+                                             QH5Dataspace::extendible({0, 3}, {QH5Dataspace::UNLIMITED, 3}),
+                                             QH5Datatype::fromValue(double()), opt);
+        if (!level.isValid()) return p;
+        p.levels_.push_back(level);
+    }
+
+    p.ds_ = ds;
+    p.minBin_ = bin;
+    p.update();
+    return p;
+}
+
+QH5Pyramid QH5Pyramid::open(const QH5Group& g, const char* name)
+{
+    QH5Pyramid p;
+    QByteArray gname = lodName(name);
+    if (!g.isValid() || !g.isDataset(name) || !g.isGroup(gname)) return p;
+
+    QH5Group lod = g.openGroup(gname);
+    quint64 bin = 0;
+    if (lod.hasAttribute("minBinSize")) lod.readAttribute("minBinSize", bin);
+    if (!bin) return p;
+
+    for(int k=0; lod.isDataset(levelName(k)); ++k)
+        p.levels_.push_back(lod.openDataset(levelName(k)));
+    if (p.levels_.isEmpty()) return p;
+
+    p.ds_ = g.openDataset(name);
+    p.minBin_ = bin;
+    return p;
+}
+
+quint64 QH5Pyramid::levelSize(int k) const
+{
+    if (k < 0 || k >= levels_.size()) return 0;
+    return levels_[k].dataspace().dimensions()[0];
+}
+
+quint64 QH5Pyramid::sourceSize() const
+{
+    return ds_.dataspace().dimensions()[0];
+}
+
+bool QH5Pyramid::update() const
+{
+    if (!isValid()) return false;
+
+    // level 0 from the raw samples
+    quint64 done = levelSize(0), target = sourceSize() / minBin_;
+    while (done < target) {
+        quint64 nb = qMin(updateBlock, target - done);
+        QVector<double> s = readSamples(ds_, done*minBin_, nb*minBin_);
+        if (quint64(s.size()) != nb*minBin_) return false;
+
+        QVector<double> rows(3*nb);
+        const double* p = s.constData();
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        for(quint64 i=0; i<nb; ++i) {
+            // NaN samples are skipped, a bin of only NaN is stored as NaN
+            double mn = nan, mx = nan, sum = 0;
+            quint64 cnt = 0;
+            for(quint64 j=0; j<minBin_; ++j) {
+                double v = p[j];
+                if (v != v) continue;
+                if (!cnt || v < mn) mn = v;
+                if (!cnt || v > mx) mx = v;
+                sum += v;
+                cnt++;
+            }
+            rows[3*i] = mn;
+            rows[3*i+1] = mx;
+            rows[3*i+2] = cnt ? sum / cnt : nan;
+            p += minBin_;
+        }
+        if (!levels_[0].append(rows.constData(), rows.size())) return false;
+        done += nb;
+    }
+
+    // each level from pairs of bins of the level below
+    for(int k=1; k<levels_.size(); ++k) {
+        done = levelSize(k);
+        target = levelSize(k-1) / 2;
+        while (done < target) {
+            quint64 nb = qMin(updateBlock, target - done);
+            QVector<double> r = readRows(levels_[k-1], 2*done, 2*nb);
+            if (quint64(r.size()) != 6*nb) return false;
+
+            QVector<double> rows(3*nb);
+            for(quint64 i=0; i<nb; ++i) {
+                const double* a = r.constData() + 6*i;
+                const double* b = a + 3;
+                // a bin of only NaN does not contribute
+                if (a[2] != a[2]) a = b;
+                else if (b[2] != b[2]) b = a;
+                rows[3*i] = qMin(a[0], b[0]);
+                rows[3*i+1] = qMax(a[1], b[1]);
+                rows[3*i+2] = 0.5*(a[2] + b[2]);
+            }
+            if (!levels_[k].append(rows.constData(), rows.size())) return false;
+            done += nb;
+        }
+    }
+    return true;
+}
+
+void QH5Pyramid::collect(int k, quint64 b0, quint64 b1, QVector<Acc>& out) const
+{
+    quint64 n = sourceSize();
+    quint64 bin = k < 0 ? 1 : binSize(k);
+    b1 = qMin(b1, (n + bin - 1) / bin);
+    if (b0 >= b1) return;
+
+    if (k < 0) {
+        QVector<double> s = readSamples(ds_, b0, b1 - b0);
+        foreach(double v, s) out.push_back(v != v ? Acc() : Acc(v, v, v, 1));
+        return;
+    }
+
+    // stored bins
+    quint64 stored = qMin(b1, levelSize(k));
+    if (b0 < stored) {
+        QVector<double> r = readRows(levels_[k], b0, stored - b0);
+        for(int i=0; i+2<r.size(); i+=3)
+            out.push_back(Acc(r[i], r[i+1], r[i+2], bin));
+        b0 = stored;
+    }
+    if (b0 >= b1) return;
+
+    // bins not yet in this level, from the level below
+    quint64 ratio = k ? 2 : minBin_;
+    QVector<Acc> lower;
+    collect(k - 1, b0*ratio, b1*ratio, lower);
+    for(int i=0; i<lower.size(); i+=int(ratio), ++b0) {
+        Acc a;
+        for(int j=i; j<lower.size() && j<i+int(ratio); ++j) a.add(lower[j]);
+        // weighted by the samples it covers, NaN or not, like the stored bins,
+        // so that the halves of a complete bin have equal weight as in update()
+        if (a.n) {
+            quint64 covered = qMin(bin, n - b0*bin);
+            a.sum = a.sum / a.n * covered;
+            a.n = covered;
+        }
+        out.push_back(a);
+    }
+}
+
+QH5Pyramid::Bins QH5Pyramid::readLevel(int k, quint64 firstBin, quint64 n) const
+{
+    Bins b;
+    if (!isValid() || k < -1 || k >= levels_.size()) return b;
+
+    QVector<Acc> acc;
+    collect(k, firstBin, firstBin + n, acc);
+
+    b.binSize = k < 0 ? 1 : binSize(k);
+    b.first = firstBin * b.binSize;
+    b.min.resize(acc.size());
+    b.max.resize(acc.size());
+    b.mean.resize(acc.size());
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for(int i=0; i<acc.size(); ++i) {
+        bool empty = !acc[i].n;
+        b.min[i] = empty ? nan : acc[i].min;
+        b.max[i] = empty ? nan : acc[i].max;
+        b.mean[i] = empty ? nan : acc[i].sum / acc[i].n;
+    }
+    return b;
+}
+
+QH5Pyramid::Bins QH5Pyramid::readDecimated(quint64 first, quint64 count, int pixels) const
+{
+    if (!isValid() || !count || pixels < 1) return Bins();
+
+    // coarsest level with a bin per pixel
+    quint64 perPixel = count / pixels;
+    int k = -1;
+    while (k + 1 < levels_.size() && binSize(k + 1) <= perPixel) ++k;
+
+    quint64 bin = k < 0 ? 1 : binSize(k);
+    quint64 b0 = first / bin, b1 = (first + count + bin - 1) / bin;
+    return readLevel(k, b0, b1 - b0);
+}
@@ -0,0 +1,182 @@
+#ifndef QH5PYRAMID_H
+#define QH5PYRAMID_H
+
+#include "qthdf5.h"
+
+/**
+ * @brief Multi-resolution min/max/mean summary of a 1D dataset
+ *
+ * QH5Pyramid maintains decimated copies of a 1D numeric dataset for plotting
+ * long time series. Level k divides the source in bins of
+ * minBinSize() * 2^k samples and stores the minimum, maximum and mean of each bin.
+ *
+ * The levels are kept in a group next to the source dataset, named after it
+ * with the suffix ".lod". Level k is the dataset "L<k>" of shape (bins, 3) with
+ * the columns min, max, mean as doubles. Other HDF5 applications can read them directly.
+ *
+ * NaN samples are skipped: min, max and mean are those of the other samples
+ * of a bin, and a bin with only NaN samples has NaN min, max and mean.
+ * The mean of a bin above level 0 is the mean of its two halves, also when
+ * readLevel() computes a bin that is not stored yet. Only the partial last bin
+ * weights its halves by the number of samples they cover.
+ *
+ * Only complete bins are stored. update() processes the samples appended to the
+ * source since the last update: level 0 is computed from the new raw samples and
+ * each higher level from the new bins of the level below.
+ *
+ * \code
+ * QH5Group g = h5f.root();
+ * QH5Pyramid p = QH5Pyramid::create(g, "adc");
+ * while (acquiring) p.append(samples.constData(), samples.size());
+ *
+ * // in the viewer: bins for a plot 1600 pixels wide
+ * QH5Pyramid::Bins b = QH5Pyramid::open(g, "adc").readDecimated(t0, t1 - t0, 1600);
+ * \endcode
+ *
+ * readDecimated() picks the coarsest level that still has a bin per pixel, so a
+ * zoomed-out view of a week-long trace reads a few thousand bins instead of the raw samples.
+ *
+ */
+class HDF_EXPORT QH5Pyramid
+{
+public:
+    /**
+     * @brief Decimated data returned by readDecimated() and readLevel()
+     *
+     * Bin i covers the samples first + i*binSize ... first + (i+1)*binSize - 1.
+     * The last bin may be partial at the end of the source.
+     */
+    struct Bins {
+        quint64 first;          //!< index of the first sample of the first bin
+        quint64 binSize;        //!< samples per bin, 1 if raw samples are returned
+        QVector<double> min;    //!< minimum of each bin
+        QVector<double> max;    //!< maximum of each bin
+        QVector<double> mean;   //!< mean of each bin
+
+        Bins() : first(0), binSize(1) {}
+        /**
+         * @brief Number of bins
+         */
+        int size() const { return mean.size(); }
+    };
+
+    /**
+     * @brief Construct an invalid QH5Pyramid
+     */
+    QH5Pyramid() : minBin_(0) {}
+
+    /**
+     * @brief Create the levels for dataset name in group g
+     *
+     * Existing levels are replaced. The levels are filled with the current
+     * data by calling update().
+     *
+     * @param g The group of the source dataset
+     * @param name The name of a 1D numeric dataset in g
+     * @param minBinSize Samples per bin of level 0, rounded up to a power of 2
+     * @param levels Number of levels
+     * @return QH5Pyramid The pyramid, invalid if the source is not a 1D dataset
+     */
+    static QH5Pyramid create(const QH5Group& g, const char* name,
+                             int minBinSize = 64, int levels = 14);
+
+    /**
+     * @brief Open the existing levels of dataset name in group g
+     *
+     * @return QH5Pyramid The pyramid, invalid if it does not exist
+     */
+    static QH5Pyramid open(const QH5Group& g, const char* name);
+
+    /**
+     * @brief Returns true if the pyramid refers to a source and its levels
+     */
+    bool isValid() const { return ds_.isValid() && !levels_.isEmpty(); }
+
+    /**
+     * @brief Return the source dataset
+     */
+    const QH5Dataset& dataset() const { return ds_; }
+
+    /**
+     * @brief Number of levels
+     */
+    int levelCount() const { return levels_.size(); }
+
+    /**
+     * @brief Samples per bin of level 0
+     */
+    quint64 minBinSize() const { return minBin_; }
+
+    /**
+     * @brief Samples per bin of level k
+     */
+    quint64 binSize(int k) const { return minBin_ << k; }
+
+    /**
+     * @brief Number of bins stored in level k
+     */
+    quint64 levelSize(int k) const;
+
+    /**
+     * @brief Bring the levels up to date with the source dataset
+     *
+     * Only the samples appended since the last update are read.
+     *
+     * @return true If succesfull
+     */
+    bool update() const;
+
+    /**
+     * @brief Append n samples to the source and update the levels
+     *
+     * Each call extends the source once (see QH5Dataset::append()) and runs
+     * update(), so the samples should be passed in large blocks, e.g., a chunk
+     * or more. Small pieces can be collected with a QH5Appender on dataset(),
+     * calling update() after QH5Appender::flush().
+     *
+     * @tparam T Type of the samples
+     * @param data Pointer to n samples
+     * @param n Number of samples
+     * @return true if the data was written
+     */
+    template<typename T>
+    bool append(const T* data, quint64 n) const
+    {
+        return isValid() && ds_.append(data, n) && update();
+    }
+
+    /**
+     * @brief Read the samples first ... first + count - 1 decimated for a plot of width pixels
+     *
+     * The coarsest level with at least pixels bins in the range is used.
+     * If the range is too short for level 0, the raw samples are returned with binSize 1.
+     *
+     * The bins are aligned to the level, so that the first and the last bin
+     * may extend outside the range. Samples not yet included in a level by
+     * update() are summarized from the level below or from the source.
+     *
+     * @param first Index of the first sample
+     * @param count Number of samples
+     * @param pixels Width of the plot
+     * @return Bins The decimated data, empty if the range is outside the source
+     */
+    Bins readDecimated(quint64 first, quint64 count, int pixels) const;
+
+    /**
+     * @brief Read bins firstBin ... firstBin + n - 1 of level k
+     *
+     * Level -1 returns the raw samples.
+     */
+    Bins readLevel(int k, quint64 firstBin, quint64 n) const;
+
+private:
+    QH5Dataset ds_;
+    QVector<QH5Dataset> levels_;
+    quint64 minBin_;
+
+    struct Acc;
+    quint64 sourceSize() const;
+    void collect(int k, quint64 b0, quint64 b1, QVector<Acc>& out) const;
+};
+
+#endif // QH5PYRAMID_H
@@ -0,0 +1,401 @@
+#include "qh5reduce.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtAlgorithms>
+
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+typedef QH5Reduce::Result Result;
+
+// elements per kernel task, at least
+const quint64 minTaskSize = 16384;
+
+// elements per block by default, at least, to amortize the setup of readParallel()
+const quint64 minBlockSize = 1 << 20;
+
+/*
+ * Reduction kernels
+ *
+ * min/max ignore NaN because (v < m) and (v > m) are false for a NaN v,
+ * as are the min/max instructions, which return the second operand.
+ */
+template<typename T>
+void reduce(const T* p, quint64 n, Result& r)
+{
+    double sum = 0, mn = r.min, mx = r.max;
+    quint64 nan = 0;
+    for(quint64 i=0; i<n; ++i) {
+        double v = p[i];
+        if (v != v) {
+            nan++;
+            continue;
+        }
+        sum += v;
+        if (v < mn) mn = v;
+        if (v > mx) mx = v;
+    }
+    r.sum += sum;
+    r.min = mn;
+    r.max = mx;
+    r.count += n - nan;
+    r.nanCount += nan;
+}
+
+#if defined(__AVX2__)
+
+void reduce(const float* p, quint64 n, Result& r)
+{
+    __m256 vmin = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 vmax = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    quint64 nan = 0, i = 0;
+    for(; i+8<=n; i+=8) {
+        __m256 v = _mm256_loadu_ps(p + i);
+        __m256 ord = _mm256_cmp_ps(v, v, _CMP_ORD_Q);
+        vmin = _mm256_min_ps(v, vmin);
+        vmax = _mm256_max_ps(v, vmax);
+        // sum in double, NaN replaced by 0
+        __m256 z = _mm256_and_ps(v, ord);
+        s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(z)));
+        s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(z, 1)));
+        nan += qPopulationCount(quint32(~_mm256_movemask_ps(ord) & 0xff));
+    }
+
+    float mn[8], mx[8];
+    double s[4];
+    _mm256_storeu_ps(mn, vmin);
+    _mm256_storeu_ps(mx, vmax);
+    _mm256_storeu_pd(s, _mm256_add_pd(s0, s1));
+    for(int k=0; k<8; ++k) {
+        if (mn[k] < r.min) r.min = mn[k];
+        if (mx[k] > r.max) r.max = mx[k];
+    }
+    r.sum += (s[0] + s[1]) + (s[2] + s[3]);
+    r.count += i - nan;
+    r.nanCount += nan;
+    reduce<float>(p + i, n - i, r);
+}
+
+void reduce(const double* p, quint64 n, Result& r)
+{
+    __m256d vmin = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    __m256d vmax = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    quint64 nan = 0, i = 0;
+    for(; i+8<=n; i+=8) {
+        __m256d a = _mm256_loadu_pd(p + i), b = _mm256_loadu_pd(p + i + 4);
+        __m256d oa = _mm256_cmp_pd(a, a, _CMP_ORD_Q), ob = _mm256_cmp_pd(b, b, _CMP_ORD_Q);
+        vmin = _mm256_min_pd(a, _mm256_min_pd(b, vmin));
+        vmax = _mm256_max_pd(a, _mm256_max_pd(b, vmax));
+        s0 = _mm256_add_pd(s0, _mm256_and_pd(a, oa));
+        s1 = _mm256_add_pd(s1, _mm256_and_pd(b, ob));
+        nan += qPopulationCount(quint32(~(_mm256_movemask_pd(oa) | _mm256_movemask_pd(ob) << 4) & 0xff));
+    }
+
+    double mn[4], mx[4], s[4];
+    _mm256_storeu_pd(mn, vmin);
+    _mm256_storeu_pd(mx, vmax);
+    _mm256_storeu_pd(s, _mm256_add_pd(s0, s1));
+    for(int k=0; k<4; ++k) {
+        if (mn[k] < r.min) r.min = mn[k];
+        if (mx[k] > r.max) r.max = mx[k];
+    }
+    r.sum += (s[0] + s[1]) + (s[2] + s[3]);
+    r.count += i - nan;
+    r.nanCount += nan;
+    reduce<double>(p + i, n - i, r);
+}
+
+#elif defined(__SSE2__)
+
+void reduce(const float* p, quint64 n, Result& r)
+{
+    __m128 vmin = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128 vmax = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    quint64 nan = 0, i = 0;
+    for(; i+4<=n; i+=4) {
+        __m128 v = _mm_loadu_ps(p + i);
+        __m128 ord = _mm_cmpord_ps(v, v);
+        vmin = _mm_min_ps(v, vmin);
+        vmax = _mm_max_ps(v, vmax);
+        // sum in double, NaN replaced by 0
+        __m128 z = _mm_and_ps(v, ord);
+        s0 = _mm_add_pd(s0, _mm_cvtps_pd(z));
+        s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(z, z)));
+        nan += qPopulationCount(quint32(~_mm_movemask_ps(ord) & 0xf));
+    }
+
+    float mn[4], mx[4];
+    double s[2];
+    _mm_storeu_ps(mn, vmin);
+    _mm_storeu_ps(mx, vmax);
+    _mm_storeu_pd(s, _mm_add_pd(s0, s1));
+    for(int k=0; k<4; ++k) {
+        if (mn[k] < r.min) r.min = mn[k];
+        if (mx[k] > r.max) r.max = mx[k];
+    }
+    r.sum += s[0] + s[1];
+    r.count += i - nan;
+    r.nanCount += nan;
+    reduce<float>(p + i, n - i, r);
+}
+
+void reduce(const double* p, quint64 n, Result& r)
+{
+    __m128d vmin = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    __m128d vmax = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    quint64 nan = 0, i = 0;
+    for(; i+4<=n; i+=4) {
+        __m128d a = _mm_loadu_pd(p + i), b = _mm_loadu_pd(p + i + 2);
+        __m128d oa = _mm_cmpord_pd(a, a), ob = _mm_cmpord_pd(b, b);
+        vmin = _mm_min_pd(a, _mm_min_pd(b, vmin));
+        vmax = _mm_max_pd(a, _mm_max_pd(b, vmax));
+        s0 = _mm_add_pd(s0, _mm_and_pd(a, oa));
+        s1 = _mm_add_pd(s1, _mm_and_pd(b, ob));
+        nan += qPopulationCount(quint32(~(_mm_movemask_pd(oa) | _mm_movemask_pd(ob) << 2) & 0xf));
+    }
+
+    double mn[2], mx[2], s[2];
+    _mm_storeu_pd(mn, vmin);
+    _mm_storeu_pd(mx, vmax);
+    _mm_storeu_pd(s, _mm_add_pd(s0, s1));
+    for(int k=0; k<2; ++k) {
+        if (mn[k] < r.min) r.min = mn[k];
+        if (mx[k] > r.max) r.max = mx[k];
+    }
+    r.sum += s[0] + s[1];
+    r.count += i - nan;
+    r.nanCount += nan;
+    reduce<double>(p + i, n - i, r);
+}
+
+#endif
+
+template<typename T>
+void histogram(const T* p, quint64 n, double lo, double hi, Result& r)
+{
+    const int bins = r.histogram.size();
+    const double scale = bins / (hi - lo);
+    quint64* h = r.histogram.data();
+    for(quint64 i=0; i<n; ++i) {
+        double v = p[i];
+        if (v != v) continue;
+        if (v < lo) r.underflow++;
+        else if (v > hi) r.overflow++;
+        else {
+            int b = int((v - lo)*scale);
+            h[b < bins ? b : bins - 1]++;
+        }
+    }
+}
+
+/*
+ * Shared state between the reading thread and the kernel tasks
+ */
+struct ReduceState
+{
+    int bins;
+    double lo, hi;
+
+    QMutex mutex;
+    QWaitCondition done;
+    int pending[2]; // tasks using each of the two buffers
+    Result total;
+
+    void wait(int buf)
+    {
+        QMutexLocker lock(&mutex);
+        while (pending[buf]) done.wait(&mutex);
+    }
+    void waitAll()
+    {
+        QMutexLocker lock(&mutex);
+        while (pending[0] || pending[1]) done.wait(&mutex);
+    }
+};
+
+template<typename T>
+class ReduceTask : public QRunnable
+{
+    ReduceState* s_;
+    const T* p_;
+    quint64 n_;
+    int buf_;
+public:
+    ReduceTask(ReduceState* s, const T* p, quint64 n, int buf) :
+        s_(s), p_(p), n_(n), buf_(buf) {}
+
+    void run() override
+    {
+        Result r;
+        reduce(p_, n_, r);
+        if (s_->bins) {
+            r.histogram.fill(0, s_->bins);
+            histogram(p_, n_, s_->lo, s_->hi, r);
+        }
+
+        QMutexLocker lock(&s_->mutex);
+        s_->total.merge(r);
+        s_->pending[buf_]--;
+        s_->done.wakeAll();
+    }
+};
+
+} // namespace
+
+QH5Reduce::Result::Result() : count(0), nanCount(0), sum(0),
+    min(std::numeric_limits<double>::infinity()),
+    max(-std::numeric_limits<double>::infinity()),
+    underflow(0), overflow(0)
+{
+}
+
+double QH5Reduce::Result::mean() const
+{
+    return count ? sum / count : std::numeric_limits<double>::quiet_NaN();
+}
+
+void QH5Reduce::Result::merge(const Result& o)
+{
+    count += o.count;
+    nanCount += o.nanCount;
+    sum += o.sum;
+    if (o.min < min) min = o.min;
+    if (o.max > max) max = o.max;
+    if (histogram.isEmpty()) histogram = o.histogram;
+    else if (histogram.size() == o.histogram.size())
+        for(int i=0; i<histogram.size(); ++i) histogram[i] += o.histogram[i];
+    underflow += o.underflow;
+    overflow += o.overflow;
+}
+
+QH5Reduce::QH5Reduce(const QH5Dataset& ds, QThreadPool* pool) :
+    ds_(ds), pool_(pool), bins_(0), lo_(0), hi_(0), blockChunks_(0)
+{
+}
+
+void QH5Reduce::setHistogram(int bins, double lo, double hi)
+{
+    if (bins < 0 || !(hi > lo)) bins = 0;
+    bins_ = bins;
+    lo_ = lo;
+    hi_ = hi;
+}
+
+bool QH5Reduce::run()
+{
+    result_ = Result();
+    if (!ds_.isValid()) return false;
+
+    switch (ds_.datatype().metaTypeId())
+    {
+    case QMetaType::Char:
+    case QMetaType::SChar: return run_<qint8>();
+    case QMetaType::UChar: return run_<quint8>();
+    case QMetaType::Short: return run_<qint16>();
+    case QMetaType::UShort: return run_<quint16>();
+    case QMetaType::Int: return run_<qint32>();
+    case QMetaType::UInt: return run_<quint32>();
+    case QMetaType::Long:
+    case QMetaType::LongLong: return run_<qint64>();
+    case QMetaType::ULong:
+    case QMetaType::ULongLong: return run_<quint64>();
+    case QMetaType::Float: return run_<float>();
+    case QMetaType::Double: return run_<double>();
+    default: return false;
+    }
+}
+
+template<typename T>
+bool QH5Reduce::run_()
+{
+    QThreadPool* pool = pool_ ? pool_ : QThreadPool::globalInstance();
+    const int threads = qMax(1, pool->maxThreadCount());
+
+    QH5Dataspace space = ds_.dataspace();
+    if (space.rank() == 0) {
+        // scalar (dimensions() returns {1}) or null dataspace, no tasks
+        QVector<T> v;
+        if (!ds_.read(v)) return false;
+        reduce(v.constData(), v.size(), result_);
+        if (bins_) {
+            result_.histogram.fill(0, bins_);
+            histogram(v.constData(), v.size(), lo_, hi_, result_);
+        }
+        return true;
+    }
+
+    ReduceState s;
+    s.bins = bins_;
+    s.lo = lo_;
+    s.hi = hi_;
+    s.pending[0] = s.pending[1] = 0;
+    if (bins_) s.total.histogram.fill(0, bins_);
+
+    QVector<quint64> dims = space.dimensions();
+    quint64 recSize = 1;
+    for(int i=1; i<dims.size(); ++i) recSize *= dims[i];
+    if (!dims[0] || !recSize) {
+        result_ = s.total;
+        return true;
+    }
+
+    // blocks of whole rows of chunks, at least one chunk per thread by default
+    QVector<quint64> chunk = ds_.createOptions().chunk();
+    quint64 chunkRows = chunk.isEmpty() ? qMax<quint64>(1, (1 << 16) / recSize) : chunk[0];
+    quint64 nchunks = blockChunks_;
+    if (nchunks < 1)
+        nchunks = qMax<quint64>(threads, minBlockSize / (chunkRows * recSize));
+    quint64 rows = chunkRows * nchunks;
+
+    QVector<T> buf[2];
+    int k = 0;
+    bool ok = true;
+    try {
+        for(quint64 r0=0; ok && r0<dims[0]; r0+=rows, k^=1) {
+            s.wait(k); // the tasks of the block before the last one
+
+            QVector<quint64> offset(dims.size(), 0), count(dims);
+            offset[0] = r0;
+            count[0] = qMin(rows, dims[0] - r0);
+            QH5Dataspace sel = ds_.dataspace();
+            sel.selectHyperslab(offset, count);
+            ok = ds_.readParallel(buf[k], sel, pool);
+            if (!ok) break;
+
+            const T* p = buf[k].constData();
+            quint64 n = buf[k].size();
+            int parts = int(qBound<quint64>(1, n / minTaskSize, threads));
+            {
+                QMutexLocker lock(&s.mutex);
+                s.pending[k] += parts;
+            }
+            for(int j=0; j<parts; ++j) {
+                quint64 a = n*j/parts, b = n*(j+1)/parts;
+                pool->start(new ReduceTask<T>(&s, p + a, b - a, k));
+            }
+        }
+    }
+    catch (...) {
+        // the tasks refer to local data
+        s.waitAll();
+        throw;
+    }
+
+    s.waitAll();
+    result_ = s.total;
+    return ok;
+}
@@ -0,0 +1,109 @@
+#ifndef QH5REDUCE_H
+#define QH5REDUCE_H
+
+#include "qthdf5.h"
+
+class QThreadPool;
+
+/**
+ * @brief Sum, minimum, maximum, mean and histogram of a dataset
+ *
+ * QH5Reduce computes reductions over a numeric dataset without reading it into
+ * memory as a whole. The dataset is read in blocks of whole rows of chunks with
+ * QH5Dataset::readParallel(), so that the chunks are decompressed on the
+ * threads of a pool. Each block is split among the pool threads, which run the
+ * reduction kernels, and the partial results are merged. The next block is read
+ * while the current one is being reduced, so at most two blocks are in memory.
+ *
+ * \code
+ * QH5Reduce r(h5f.dataset("run42/ch3/adc"));
+ * r.setHistogram(256, -1., 1.);
+ * if (r.run()) qDebug() << r.result().mean() << r.result().max;
+ * \endcode
+ *
+ * The kernels for float and double datasets use SSE2 or AVX2 instructions
+ * when the library is compiled for them (__SSE2__, __AVX2__, e.g., with -mavx2),
+ * otherwise portable code. Other numeric types use portable code.
+ *
+ * NaN values are counted in nanCount and do not contribute to the other results.
+ *
+ */
+class HDF_EXPORT QH5Reduce
+{
+public:
+    /**
+     * @brief The results of a reduction
+     */
+    struct Result {
+        quint64 count;      //!< number of values, not including NaN
+        quint64 nanCount;   //!< number of NaN values
+        double sum;         //!< sum of the values
+        double min;         //!< minimum, +inf if there are no values
+        double max;         //!< maximum, -inf if there are no values
+        QVector<quint64> histogram; //!< value counts in the bins set by setHistogram()
+        quint64 underflow;  //!< values below the histogram range
+        quint64 overflow;   //!< values above the histogram range
+
+        Result();
+        /**
+         * @brief Mean of the values, NaN if there are no values
+         */
+        double mean() const;
+        /**
+         * @brief Merge the results of another part of the data
+         */
+        void merge(const Result& o);
+    };
+
+    /**
+     * @brief Construct a new QH5Reduce object
+     *
+     * @param ds An integer or floating point dataset
+     * @param pool The thread pool. If null, QThreadPool::globalInstance() is used.
+     */
+    explicit QH5Reduce(const QH5Dataset& ds, QThreadPool* pool = 0);
+
+    /**
+     * @brief Also compute a histogram with bins equal bins in [lo, hi)
+     *
+     * Values equal to hi are counted in the last bin. bins = 0 disables the histogram,
+     * which is the default.
+     */
+    void setHistogram(int bins, double lo, double hi);
+
+    /**
+     * @brief Set the number of chunks along the first dimension read at a time
+     *
+     * The default of 0 selects one per pool thread, but not less than about
+     * 1M elements per block. Negative values are treated as 0.
+     */
+    void setBlockChunks(int n) { blockChunks_ = qMax(0, n); }
+
+    /**
+     * @brief Run the reduction
+     *
+     * Do not call from a thread of the pool, the function waits for the pool tasks.
+     *
+     * @return true If succesfull
+     * @return false If the dataset is invalid, not numeric or could not be read
+     */
+    bool run();
+
+    /**
+     * @brief Return the results of the last run()
+     */
+    const Result& result() const { return result_; }
+
+private:
+    QH5Dataset ds_;
+    QThreadPool* pool_;
+    int bins_;
+    double lo_, hi_;
+    int blockChunks_;
+    Result result_;
+
+    template<typename T>
+    bool run_();
+};
+
+#endif // QH5REDUCE_H
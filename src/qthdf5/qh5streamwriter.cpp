@@ -0,0 +1,358 @@
+#include "qh5streamwriter.h"
+
+#include <QThread>
+#include <QElapsedTimer>
+
+#include <hdf5.h>
+
+#include <climits>
+#include <cstring>
+
+hid_t _h(const QH5id::h5id& id);
+hid_t _h(const QH5id& id);
+
+namespace {
+
+// largest ring buffer in bytes, QByteArray holds less than 2^31 bytes
+const qint64 maxBufferSize = INT_MAX - 64;
+
+// true if a and b refer to the same object of the same file
+bool sameObject(const QH5id& a, const QH5id& b)
+{
+    if (a.isNull() || b.isNull()) return false;
+#if H5_VERSION_GE(1,12,0)
+    H5O_info2_t ia, ib;
+    if (H5Oget_info3(_h(a), &ia, H5O_INFO_BASIC) < 0 ||
+            H5Oget_info3(_h(b), &ib, H5O_INFO_BASIC) < 0)
+        throw h5exception("Error in call to H5Oget_info");
+    int cmp;
+    return ia.fileno == ib.fileno &&
+            H5Otoken_cmp(_h(a), &ia.token, &ib.token, &cmp) >= 0 && cmp == 0;
+#else
+    H5O_info_t ia, ib;
+#if H5_VERSION_GE(1,10,3)
+    if (H5Oget_info2(_h(a), &ia, H5O_INFO_BASIC) < 0 ||
+            H5Oget_info2(_h(b), &ib, H5O_INFO_BASIC) < 0)
+#else
+    if (H5Oget_info(_h(a), &ia) < 0 || H5Oget_info(_h(b), &ib) < 0)
+#endif
+        throw h5exception("Error in call to H5Oget_info");
+    return ia.fileno == ib.fileno && ia.addr == ib.addr;
+#endif
+}
+
+} // namespace
+
+class QH5StreamWriterThread : public QThread
+{
+    QH5StreamWriter* writer_;
+public:
+    explicit QH5StreamWriterThread(QH5StreamWriter* w) : writer_(w) {}
+protected:
+    void run() override { writer_->run(); }
+};
+
+QH5StreamWriter::QH5StreamWriter(const QH5Dataset& ds, int capacity,
+                                 const QH5Datatype& memtype) :
+    ds_(ds), memtype_(memtype), recordSize_(0), capacity_(0), blockSize_(1),
+    high_(0), low_(0), policy_(BLOCK), flushInterval_(1000),
+    head_(0), depth_(0), overflow_(false), stopping_(false),
+    flushRequest_(false), error_(false), thread_(0)
+{
+    memset(&stats_, 0, sizeof(stats_));
+
+    if (!ds_.isValid()) return;
+
+    if (!memtype_.isValid()) memtype_ = ds_.datatype().nativeType();
+
+    // record = one slab along the 1st dimension
+    QVector<quint64> dims = ds_.dataspace().dimensions();
+    quint64 m = 1;
+    for(int i=1; i<dims.size(); ++i) m *= dims[i];
+    quint64 recSize = m * memtype_.size();
+    // a record must fit in the ring buffer, recordSize_ = 0 makes start() fail
+    if (!recSize || recSize > quint64(maxBufferSize)) return;
+    recordSize_ = int(recSize);
+
+    QVector<quint64> chunk = ds_.createOptions().chunk();
+    qint64 block = chunk.isEmpty() ? 1024 : qint64(qMin<quint64>(chunk[0], INT_MAX));
+
+    // the ring buffer size is capacity_ * recordSize_ bytes
+    qint64 cap = capacity > 0 ? capacity : 16*block;
+    cap = qMin(cap, maxBufferSize / recordSize_);
+    capacity_ = int(cap);
+    blockSize_ = int(qMin(block, cap));
+    high_ = capacity_;
+    low_ = capacity_/2;
+
+    buffer_.resize(capacity_ * recordSize_);
+}
+
+QH5StreamWriter::~QH5StreamWriter()
+{
+    stop();
+}
+
+void QH5StreamWriter::setBlockSize(int n)
+{
+    if (isRunning() || n < 1) return;
+    blockSize_ = qMin(n, capacity_);
+}
+
+bool QH5StreamWriter::setChunkStats(const QH5ChunkStats& st)
+{
+    if (isRunning() || !st.isValid() || !ds_.isValid()) return false;
+
+    // QH5ChunkStats::record() handles only numeric data
+    QH5Datatype::Class cls = memtype_.getClass();
+    if (cls != QH5Datatype::INTEGER && cls != QH5Datatype::FLOAT) return false;
+    if (!sameObject(st.dataset(), ds_)) return false;
+
+    chunkStats_ = st;
+    return true;
+}
+
+void QH5StreamWriter::setWatermarks(int high, int low)
+{
+    QMutexLocker lock(&mutex_);
+    high_ = qMax(1, qMin(high, capacity_));
+    low_ = qMax(0, qMin(low, high_));
+}
+
+void QH5StreamWriter::setOverflowPolicy(OverflowPolicy p)
+{
+    QMutexLocker lock(&mutex_);
+    policy_ = p;
+}
+
+void QH5StreamWriter::setFlushInterval(int ms)
+{
+    QMutexLocker lock(&mutex_);
+    flushInterval_ = qMax(1, ms);
+}
+
+bool QH5StreamWriter::start()
+{
+    if (isRunning() || !ds_.isValid() || recordSize_ == 0) return false;
+
+    {
+        QMutexLocker lock(&mutex_);
+        stopping_ = false;
+        error_ = false;
+        overflow_ = false;
+    }
+
+    thread_ = new QH5StreamWriterThread(this);
+    thread_->start();
+    return true;
+}
+
+void QH5StreamWriter::stop()
+{
+    if (!thread_) return;
+
+    {
+        QMutexLocker lock(&mutex_);
+        stopping_ = true;
+        notEmpty_.wakeAll();
+        notFull_.wakeAll();
+    }
+
+    thread_->wait();
+    delete thread_;
+    thread_ = 0;
+}
+
+bool QH5StreamWriter::isRunning() const
+{
+    return thread_ && thread_->isRunning();
+}
+
+void QH5StreamWriter::flush()
+{
+    QMutexLocker lock(&mutex_);
+    flushRequest_ = true;
+    notEmpty_.wakeAll();
+}
+
+bool QH5StreamWriter::push(const void* data, int n)
+{
+    if (!data || n <= 0) return n == 0;
+
+    const char* src = static_cast<const char*>(data);
+
+    QMutexLocker lock(&mutex_);
+
+    if (!thread_ || stopping_ || error_) return false;
+
+    bool dropped = false;
+    while (n > 0) {
+
+        if (!overflow_ && depth_ >= high_) {
+            overflow_ = true;
+            notEmpty_.wakeOne();
+        }
+
+        int k; // number of records to insert
+        if (!overflow_) k = qMin(n, high_ - depth_);
+        else if (policy_ == BLOCK) {
+            QElapsedTimer t;
+            t.start();
+            while (overflow_ && !stopping_ && !error_) notFull_.wait(&mutex_);
+            stats_.stallTime += t.nsecsElapsed();
+            if (stopping_ || error_) return false;
+            continue;
+        } else if (policy_ == DROP_NEWEST) {
+            stats_.recordsDropped += n;
+            return false;
+        } else { // DROP_OLDEST
+            k = qMin(n, high_);
+            int d = qMax(0, depth_ + k - high_);
+            drop(d);
+            dropped = dropped || d > 0;
+        }
+
+        // copy into the ring, possibly in 2 pieces
+        int tail = (head_ + depth_) % capacity_;
+        int k1 = qMin(k, capacity_ - tail);
+        memcpy(buffer_.data() + tail*recordSize_, src, k1*recordSize_);
+        if (k > k1) memcpy(buffer_.data(), src + k1*recordSize_, (k-k1)*recordSize_);
+
+        src += k*recordSize_;
+        n -= k;
+        depth_ += k;
+        stats_.recordsPushed += k;
+        if (quint64(depth_) > stats_.maxQueueDepth) stats_.maxQueueDepth = depth_;
+
+        if (depth_ >= blockSize_) notEmpty_.wakeOne();
+    }
+
+    return !dropped;
+}
+
+void QH5StreamWriter::drop(int n)
+{
+    if (n <= 0) return;
+    head_ = (head_ + n) % capacity_;
+    depth_ -= n;
+    stats_.recordsDropped += n;
+}
+
+int QH5StreamWriter::take(QByteArray& out, int maxRecords)
+{
+    int n = qMin(maxRecords, depth_);
+    out.resize(n*recordSize_);
+    int n1 = qMin(n, capacity_ - head_);
+    memcpy(out.data(), buffer_.constData() + head_*recordSize_, n1*recordSize_);
+    if (n > n1) memcpy(out.data() + n1*recordSize_, buffer_.constData(), (n-n1)*recordSize_);
+    head_ = (head_ + n) % capacity_;
+    depth_ -= n;
+    return n;
+}
+
+void QH5StreamWriter::run()
+{
+    QByteArray block;
+    QElapsedTimer t;
+    bool recordStats = chunkStats_.isValid(); // until the first failure
+
+    forever {
+        int n;
+        {
+            QMutexLocker lock(&mutex_);
+
+            bool timeout = false;
+            while (!stopping_ && !flushRequest_ && !overflow_ &&
+                   depth_ < blockSize_ && !timeout)
+                timeout = !notEmpty_.wait(&mutex_, flushInterval_);
+
+            if (stopping_ && depth_ == 0) return;
+
+            // whole blocks, unless flushing or the queue is full
+            int m = depth_;
+            if (!stopping_ && !flushRequest_ && !overflow_ && !timeout)
+                m = (depth_/blockSize_)*blockSize_;
+            flushRequest_ = false;
+
+            n = take(block, m);
+
+            if (overflow_ && depth_ <= low_) {
+                overflow_ = false;
+                notFull_.wakeAll();
+            }
+        }
+
+        if (!n) continue;
+
+        t.start();
+        bool ok, statsOk = true;
+        quint64 m = quint64(n)*recordSize_/memtype_.size();
+        quint64 first = 0; // position of the first new element
+        try {
+            if (chunkStats_.isValid()) {
+                first = 1;
+                foreach(quint64 d, ds_.dataspace().dimensions()) first *= d;
+            }
+            ok = ds_.append_(block.constData(), m, memtype_);
+        }
+        catch (const h5exception&) {
+            ok = false;
+        }
+        // the statistics are secondary, a failure must not stop the data
+        if (ok && chunkStats_.isValid()) {
+            try {
+                statsOk = recordStats && chunkStats_.record(first, block.constData(), m, memtype_);
+            }
+            catch (const h5exception&) {
+                statsOk = false;
+            }
+            // later blocks would be merged into the incomplete entries, so stop
+            // recording and drop the entries from this block on, select() returns them
+            if (!statsOk && recordStats) {
+                recordStats = false;
+                try {
+                    chunkStats_.truncate(first);
+                }
+                catch (const h5exception&) {
+                    // the entries are wrong until QH5ChunkStats::rebuild()
+                }
+            }
+        }
+        qint64 dt = t.nsecsElapsed();
+
+        QMutexLocker lock(&mutex_);
+        stats_.ioTime += dt;
+        if (!statsOk) stats_.statsErrors++;
+        if (ok) {
+            stats_.writes++;
+            stats_.recordsWritten += n;
+            stats_.bytesWritten += quint64(n)*recordSize_;
+        } else {
+            // stop accepting data, release blocked producers
+            error_ = true;
+            depth_ = 0;
+            notFull_.wakeAll();
+            return;
+        }
+    }
+}
+
+int QH5StreamWriter::queueDepth() const
+{
+    QMutexLocker lock(&mutex_);
+    return depth_;
+}
+
+QH5StreamWriter::Statistics QH5StreamWriter::statistics() const
+{
+    QMutexLocker lock(&mutex_);
+    Statistics s = stats_;
+    s.queueDepth = depth_;
+    return s;
+}
+
+bool QH5StreamWriter::hasError() const
+{
+    QMutexLocker lock(&mutex_);
+    return error_;
+}
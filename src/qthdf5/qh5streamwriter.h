@@ -0,0 +1,295 @@
+#ifndef QH5STREAMWRITER_H
+#define QH5STREAMWRITER_H
+
+#include "qthdf5.h"
+#include "qh5chunkstats.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+
+class QH5StreamWriterThread;
+
+/**
+ * @brief Background writer for streaming data to an extendible dataset
+ *
+ * QH5StreamWriter decouples the threads that produce data from the HDF5 I/O.
+ *
+ * Producer threads call push() to place records in a bounded ring buffer.
+ * A single I/O thread takes the records out of the buffer, coalesces them in blocks
+ * of whole chunks and appends them to the dataset with QH5Dataset::append().
+ *
+ * A record is one slab of the dataset along its first dimension, e.g.,
+ * a single value for a 1D dataset or a row of a 2D dataset.
+ *
+ * When the number of queued records reaches the high watermark the
+ * overflow policy determines what happens: producers either wait
+ * until the queue drains to the low watermark (BLOCK) or
+ * records are dropped (DROP_NEWEST, DROP_OLDEST).
+ *
+ * \code
+ * QH5Dataset ds = root.createDataset("adc", QH5Dataspace::extendible({0}),
+ *                                    QH5Datatype::fromValue(qint16()));
+ * QH5StreamWriter writer(ds);
+ * writer.start();
+ * // in the acquisition threads
+ * writer.push(buffer, n);
+ * // at the end
+ * writer.stop();
+ * \endcode
+ *
+ * While the writer is running, HDF5 is called from the I/O thread. The
+ * HDF5 library must have been built thread-safe if other threads access
+ * HDF5 at the same time.
+ *
+ */
+class HDF_EXPORT QH5StreamWriter
+{
+    friend class QH5StreamWriterThread;
+public:
+    /**
+     * @brief What to do when the queue reaches the high watermark
+     */
+    enum OverflowPolicy {
+        BLOCK,          //!< producers wait for free space
+        DROP_NEWEST,    //!< the records being pushed are discarded until the depth drops to the low watermark
+        DROP_OLDEST     //!< the oldest queued records are discarded to make space below the high watermark
+    };
+
+    /**
+     * @brief Counters of the writer activity
+     */
+    struct Statistics {
+        quint64 queueDepth;     //!< records currently in the queue
+        quint64 maxQueueDepth;  //!< highest queue depth observed
+        quint64 recordsPushed;  //!< records accepted by push()
+        quint64 recordsWritten; //!< records written to the dataset
+        quint64 recordsDropped; //!< records discarded because of overflow
+        quint64 bytesWritten;   //!< bytes written to the dataset
+        quint64 writes;         //!< number of calls to QH5Dataset::append()
+        qint64 stallTime;       //!< total time producers were blocked, in ns
+        qint64 ioTime;          //!< total time spent in HDF5 writes, in ns
+        quint64 statsErrors;    //!< writes whose chunk statistics were not recorded
+    };
+
+    /**
+     * @brief Construct a new QH5StreamWriter object
+     *
+     * @param ds An extendible dataset
+     * @param capacity Queue capacity in records. If 0, 16 blocks are used.
+     * The queue is limited to about 2 GB, and a larger capacity is reduced accordingly.
+     * If a single record does not fit, the writer cannot be started.
+     * @param memtype Memory datatype of the pushed records. If invalid the
+     * native type of the dataset is used.
+     */
+    explicit QH5StreamWriter(const QH5Dataset& ds, int capacity = 0,
+                             const QH5Datatype& memtype = QH5Datatype());
+
+    /**
+     * @brief Destroy the QH5StreamWriter object
+     *
+     * Calls stop(), so that all queued records are written.
+     */
+    ~QH5StreamWriter();
+
+    /**
+     * @brief Set the number of records in each write
+     *
+     * Records are written in multiples of n, except when flushing.
+     * The default is the chunk size along the first dimension.
+     *
+     * Ignored if the writer is running.
+     */
+    void setBlockSize(int n);
+    /**
+     * @brief Return the number of records in each write
+     */
+    int blockSize() const { return blockSize_; }
+
+    /**
+     * @brief Set the queue watermarks in records
+     *
+     * When the queue depth reaches high the overflow policy applies until
+     * the depth drops to low. high is limited to the capacity and low to high.
+     *
+     * The defaults are the capacity and half the capacity.
+     */
+    void setWatermarks(int high, int low);
+    /**
+     * @brief Return the high watermark
+     */
+    int highWatermark() const { return high_; }
+    /**
+     * @brief Return the low watermark
+     */
+    int lowWatermark() const { return low_; }
+
+    /**
+     * @brief Set the overflow policy. The default is BLOCK.
+     */
+    void setOverflowPolicy(OverflowPolicy p);
+    /**
+     * @brief Return the overflow policy
+     */
+    OverflowPolicy overflowPolicy() const { return policy_; }
+
+    /**
+     * @brief Set the maximum time in ms that records wait in the queue
+     *
+     * After this time incomplete blocks are written. The default is 1000 ms.
+     */
+    void setFlushInterval(int ms);
+    /**
+     * @brief Return the flush interval in ms
+     */
+    int flushInterval() const { return flushInterval_; }
+
+    /**
+     * @brief Maintain per-chunk statistics of the written data
+     *
+     * After each write the I/O thread records the statistics of the
+     * written records with QH5ChunkStats::record(), from the data in memory.
+     * If recording fails the data is still written, but no statistics are
+     * recorded for the rest of the run and those of the chunks from the failed
+     * write on are removed with QH5ChunkStats::truncate(), so that queries
+     * do not skip them. The writes without statistics are counted in
+     * Statistics::statsErrors. The statistics can then be recomputed from the
+     * dataset with QH5ChunkStats::rebuild().
+     *
+     * @return true If st has been set
+     * @return false If the writer is running, st does not refer to the
+     *      dataset of the writer, or the memory datatype is not an integer
+     *      or floating point type
+     */
+    bool setChunkStats(const QH5ChunkStats& st);
+    /**
+     * @brief Return the chunk statistics maintained by the writer
+     */
+    const QH5ChunkStats& chunkStats() const { return chunkStats_; }
+
+    /**
+     * @brief Return the queue capacity in records
+     */
+    int capacity() const { return capacity_; }
+
+    /**
+     * @brief Return the size of a record in bytes
+     */
+    int recordSize() const { return recordSize_; }
+
+    /**
+     * @brief Start the I/O thread
+     *
+     * @return true If the thread has been started
+     * @return false If the writer is already running or the dataset is not valid
+     */
+    bool start();
+
+    /**
+     * @brief Stop the I/O thread
+     *
+     * Blocks until all queued records have been written and the thread has finished.
+     */
+    void stop();
+
+    /**
+     * @brief Returns true if the I/O thread is running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Write queued records without waiting for a complete block
+     *
+     * Returns immediately, the records are written by the I/O thread.
+     */
+    void flush();
+
+    /**
+     * @brief Queue n records for writing
+     *
+     * Thread-safe, can be called from any number of threads.
+     *
+     * @param data Pointer to n * recordSize() bytes
+     * @param n Number of records
+     * @return true If all records were queued
+     * @return false If records were dropped, the writer is not running or a write error occurred
+     */
+    bool push(const void* data, int n);
+
+    /**
+     * @brief Queue n records for writing
+     *
+     * T must have the layout of the memory datatype, e.g., T = qint16 for
+     * a 1D dataset of NATIVE_SHORT.
+     *
+     * @param data Pointer to n records
+     * @param n Number of records
+     */
+    template<typename T>
+    bool push(const T* data, int n)
+    {
+        return sizeof(T)==size_t(recordSize_) ? push(static_cast<const void*>(data), n) : false;
+    }
+
+    /**
+     * @brief Queue a single record
+     */
+    template<typename T>
+    bool push(const T& record)
+    {
+        return push(&record, 1);
+    }
+
+    /**
+     * @brief Returns the current number of queued records
+     */
+    int queueDepth() const;
+
+    /**
+     * @brief Returns a snapshot of the writer counters
+     */
+    Statistics statistics() const;
+
+    /**
+     * @brief Returns true if a HDF5 error occurred in the I/O thread
+     *
+     * After an error the writer stops accepting records.
+     */
+    bool hasError() const;
+
+private:
+    QH5Dataset ds_;
+    QH5Datatype memtype_;
+    int recordSize_;
+    int capacity_;
+    int blockSize_;
+    int high_;
+    int low_;
+    OverflowPolicy policy_;
+    int flushInterval_;
+    QH5ChunkStats chunkStats_;
+
+    // ring buffer
+    QByteArray buffer_;
+    int head_;  // first queued record
+    int depth_; // number of queued records
+    bool overflow_; // true between reaching high and falling below low
+    bool stopping_;
+    bool flushRequest_;
+    bool error_;
+
+    Statistics stats_;
+
+    mutable QMutex mutex_;
+    QWaitCondition notEmpty_;
+    QWaitCondition notFull_;
+
+    QH5StreamWriterThread* thread_;
+
+    void run();
+    int take(QByteArray& out, int maxRecords);
+    void drop(int n);
+
+    Q_DISABLE_COPY(QH5StreamWriter)
+};
+
+#endif // QH5STREAMWRITER_H
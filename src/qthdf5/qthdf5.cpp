@@ -3,82 +3,198 @@
 #include <hdf5.h>
 
 #include <QtDebug>
+#include <QAtomicInt>
+#include <QCache>
+#include <QMutex>
 
 hid_t _h(const QH5id::h5id& v) { return static_cast<hid_t>(v); }
 hid_t _h(const QH5id& v) { return static_cast<hid_t>(v.id()); }
 
-QH5id::QH5id(h5id id, bool incref) : id_(id)
+/*********** REGISTRY ************/
+/*
+ * Handles that are created once per process and shared by all wrappers:
+ * native datatypes, scalar/null dataspaces and standard property lists.
+ *
+ * The registry is built on first use (function-local static, thread-safe)
+ * and never modified afterwards. Wrappers take a reference to a handle
+ * (H5Iinc_ref) instead of creating or copying an HDF5 object.
+ *
+ * Predefined types like H5T_NATIVE_INT cannot be closed, so copies
+ * are kept instead. The datatypes are locked (H5Tlock), so that changing
+ * a shared handle, e.g., with setStringTraits(), fails instead of
+ * affecting every later user.
+ */
+namespace {
+
+hid_t complexType(hid_t base)
+{
+    size_t sz = H5Tget_size(base);
+    hid_t t = H5Tcreate(H5T_COMPOUND, 2*sz);
+    H5Tinsert(t, "r", 0, base);
+    H5Tinsert(t, "i", sz, base);
+    return t;
+}
+
+struct QH5Registry
+{
+    QH5id native[QH5Datatype::NATIVE_TYPE_COUNT];
+    QH5id utf8String;       // variable length UTF8 string
+    QH5id scalarSpace;      // H5S_SCALAR
+    QH5id nullSpace;        // H5S_NULL
+    QH5id gcplCreationOrder;// group creation, link creation order tracked & indexed
+    QH5id lcplIntermediate; // link creation, create intermediate groups
+
+    QH5Registry()
+    {
+        static const hid_t predefined[] = {
+            H5T_NATIVE_INT8, H5T_NATIVE_UINT8, H5T_NATIVE_INT16, H5T_NATIVE_UINT16,
+            H5T_NATIVE_INT32, H5T_NATIVE_UINT32, H5T_NATIVE_INT64, H5T_NATIVE_UINT64,
+            H5T_NATIVE_FLOAT, H5T_NATIVE_DOUBLE, H5T_NATIVE_LDOUBLE, H5T_NATIVE_HBOOL
+        };
+        for(int i=0; i<QH5Datatype::NATIVE_COMPLEX_FLOAT; ++i)
+            native[i] = QH5id(H5Tcopy(predefined[i]),false);
+        native[QH5Datatype::NATIVE_COMPLEX_FLOAT] = QH5id(complexType(H5T_NATIVE_FLOAT),false);
+        native[QH5Datatype::NATIVE_COMPLEX_DOUBLE] = QH5id(complexType(H5T_NATIVE_DOUBLE),false);
+
+        hid_t t = H5Tcopy(H5T_C_S1);
+        H5Tset_cset(t, H5T_CSET_UTF8);
+        H5Tset_size(t, H5T_VARIABLE);
+        utf8String = QH5id(t,false);
+
+        for(int i=0; i<QH5Datatype::NATIVE_TYPE_COUNT; ++i)
+            if (H5Tlock(_h(native[i])) < 0) throw h5exception("Error in call to H5Tlock");
+        if (H5Tlock(_h(utf8String)) < 0) throw h5exception("Error in call to H5Tlock");
+
+        scalarSpace = QH5id(H5Screate(H5S_SCALAR),false);
+        nullSpace = QH5id(H5Screate(H5S_NULL),false);
+
+        hid_t p = H5Pcreate(H5P_GROUP_CREATE);
+        H5Pset_link_creation_order(p, H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+        gcplCreationOrder = QH5id(p,false);
+
+        p = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(p, 1);
+        lcplIntermediate = QH5id(p,false);
+    }
+
+    static const QH5Registry& instance()
+    {
+        // never destroyed, locked datatypes cannot be freed by the user.
+        // The library releases all ids when it shuts down.
+        static const QH5Registry* r = new QH5Registry;
+        return *r;
+    }
+};
+
+} // namespace
+
+QH5id::QH5id(h5id id, bool incref) : id_(id), kind_(KIND_UNKNOWN)
 {
     if (id_ > 0 && incref) ref();
 }
 
-QH5id::QH5id(const QH5id& o) : id_(o.id_)
+QH5id::QH5id(h5id id, bool incref, Kind kind) : id_(id), kind_(kind)
 {
-    if (isValid()) ref();
+    if (id_ > 0 && incref) ref();
+}
+
+QH5id::QH5id(const QH5id& o) : id_(o.id_), kind_(o.kind_)
+{
+    if (!isNull()) ref();
 }
 
 QH5id& QH5id::operator=(const QH5id& o)
 {
     if (this == &o) return *this;
 
-    if (isValid()) close();
-    if (o.isValid()) o.ref();
+    if (!o.isNull()) o.ref();
+    if (!isNull()) close();
 
     id_ = o.id_;
+    kind_ = o.kind_;
+
+    return *this;
+}
+
+QH5id& QH5id::operator=(QH5id&& o)
+{
+    if (this == &o) return *this;
+
+    if (!isNull()) close();
+
+    id_ = o.id_;
+    kind_ = o.kind_;
+    o.id_ = 0;
 
     return *this;
 }
 
 bool QH5id::close()
 {
-    if (isValid()) {
-        H5I_type_t type = H5Iget_type(_h(id_));
-        herr_t error_code = 0;
+    if (isNull()) return false;
 
-        switch (type)
-        {
-        case H5I_DATASPACE:
-            error_code = H5Sclose(_h(id_));
-            break;
-        case H5I_GROUP:
-            error_code = H5Gclose(_h(id_));
-            break;
-        case H5I_DATATYPE:
-            error_code = H5Tclose(_h(id_));
-            break;
-        case H5I_ATTR:
-            error_code = H5Aclose(_h(id_));
-            break;
-        case H5I_FILE:
-            error_code = H5Fclose(_h(id_));
-            break;
-        case H5I_GENPROP_LST:
-            error_code = H5Pclose(_h(id_));
-            break;
-        case H5I_GENPROP_CLS:
-            error_code = H5Pclose_class(_h(id_));
-            break;
-        case H5I_ERROR_MSG:
-            error_code = H5Eclose_msg(_h(id_));
-            break;
-        case H5I_ERROR_STACK:
-            error_code = H5Eclose_stack(_h(id_));
-            break;
-        case H5I_ERROR_CLASS:
-            error_code = H5Eunregister_class(_h(id_));
-            break;
-        default:
-            error_code = H5Oclose(_h(id_));
-        }
+    H5I_type_t type;
+    switch (kind_)
+    {
+    case KIND_FILE:      type = H5I_FILE; break;
+    case KIND_GROUP:     type = H5I_GROUP; break;
+    case KIND_DATATYPE:  type = H5I_DATATYPE; break;
+    case KIND_DATASPACE: type = H5I_DATASPACE; break;
+    case KIND_DATASET:   type = H5I_DATASET; break;
+    default:             type = H5Iget_type(_h(id_));
+    }
 
-        id_ = 0;
-        if (error_code < 0) {
-            throw h5exception("Error closing H5 id");
-            return false;
-        } else return true;
+    herr_t error_code = 0;
 
+    switch (type)
+    {
+    case H5I_DATASPACE:
+        error_code = H5Sclose(_h(id_));
+        break;
+    case H5I_GROUP:
+        error_code = H5Gclose(_h(id_));
+        break;
+    case H5I_DATATYPE:
+        // H5Tclose refuses locked (shared) datatypes
+        error_code = H5Idec_ref(_h(id_));
+        break;
+    case H5I_ATTR:
+        error_code = H5Aclose(_h(id_));
+        break;
+    case H5I_FILE:
+        error_code = H5Fclose(_h(id_));
+        break;
+    case H5I_GENPROP_LST:
+        error_code = H5Pclose(_h(id_));
+        break;
+    case H5I_GENPROP_CLS:
+        error_code = H5Pclose_class(_h(id_));
+        break;
+    case H5I_ERROR_MSG:
+        error_code = H5Eclose_msg(_h(id_));
+        break;
+    case H5I_ERROR_STACK:
+        error_code = H5Eclose_stack(_h(id_));
+        break;
+    case H5I_ERROR_CLASS:
+        error_code = H5Eunregister_class(_h(id_));
+        break;
+    case H5I_BADID:
+        // not a valid id (e.g. closed outside QtHDF5)
+        id_ = 0;
+        return false;
+    default:
+        error_code = H5Oclose(_h(id_));
     }
-    return false;
+
+    h5id id = id_;
+    id_ = 0;
+    if (error_code < 0) {
+        // an id that was already invalid is not an error
+        if (H5Iis_valid(_h(id)) <= 0) return false;
+        throw h5exception("Error closing H5 id");
+        return false;
+    } else return true;
 }
 
 bool QH5id::isValid() const
@@ -103,10 +219,14 @@ QByteArray QH5id::name() const
 }
 bool QH5id::isGroup() const
 {
+    if (isNull()) return false;
+    if (kind_ != KIND_UNKNOWN) return kind_ == KIND_GROUP;
     return H5Iget_type(_h(id_))==H5I_GROUP;
 }
 bool QH5id::isDataset() const
 {
+    if (isNull()) return false;
+    if (kind_ != KIND_UNKNOWN) return kind_ == KIND_DATASET;
     return H5Iget_type(_h(id_))==H5I_DATASET;
 }
 QH5Group QH5id::toGroup() const
@@ -134,7 +254,9 @@ int QH5id::refcount() const
 
 
 /************* DATASPACE **************/
-QH5Dataspace::QH5Dataspace(const QVector<quint64>& dims)
+const quint64 QH5Dataspace::UNLIMITED;
+
+QH5Dataspace::QH5Dataspace(const QVector<quint64>& dims) : QH5id(0,false,KIND_DATASPACE)
 {
     if (!dims.isEmpty()) {
         hid_t space_id;
@@ -148,6 +270,16 @@ QH5Dataspace QH5Dataspace::scalar()
 {
     return QH5Dataspace(static_cast<h5id>(H5Screate(H5S_SCALAR)),false);
 }
+QH5Dataspace QH5Dataspace::extendible(const QVector<quint64>& dims,
+                                      const QVector<quint64>& maxdims)
+{
+    QVector<quint64> m = maxdims.isEmpty() ? QVector<quint64>(dims.size(),UNLIMITED) : maxdims;
+    if (dims.isEmpty() || dims.size()!=m.size()) return QH5Dataspace();
+
+    hid_t space_id = H5Screate_simple (dims.size(), dims.constData(), m.constData());
+    if (space_id < 0) throw h5exception("Error in call to H5Screate_simple");
+    return QH5Dataspace(static_cast<h5id>(space_id),false);
+}
 QVector<quint64> QH5Dataspace::dimensions() const
 {
     QVector<quint64> dims;
@@ -171,54 +303,145 @@ QVector<quint64> QH5Dataspace::dimensions() const
 
     return dims;
 }
+QVector<quint64> QH5Dataspace::maxDimensions() const
+{
+    if (!isValid()) return QVector<quint64>();
+    if (H5Sget_simple_extent_type(_h(id_)) != H5S_SIMPLE) return dimensions();
+
+    int r = rank();
+    QVector<quint64> dims(r), maxdims(r);
+    if (H5Sget_simple_extent_dims(_h(id_), dims.data(), maxdims.data()) < 0)
+        throw h5exception("Error in call to H5Sget_simple_extent_dims");
+    return maxdims;
+}
+bool QH5Dataspace::isExtendible() const
+{
+    return dimensions() != maxDimensions();
+}
 int QH5Dataspace::size() const
 {
     hssize_t s = H5Sget_simple_extent_npoints(_h(id_));
     if (s < 0) throw h5exception("H5Sget_simple_extent_npoints failed");
     return s;
 }
+int QH5Dataspace::rank() const
+{
+    int r = H5Sget_simple_extent_ndims(_h(id_));
+    if (r < 0) throw h5exception("Error in call to H5Sget_simple_extent_ndims");
+    return r;
+}
+bool QH5Dataspace::selectAll() const
+{
+    if (!isValid()) return false;
+    herr_t ret = H5Sselect_all(_h(id_));
+    if (ret < 0) throw h5exception("Error in call to H5Sselect_all");
+    return true;
+}
+bool QH5Dataspace::selectNone() const
+{
+    if (!isValid()) return false;
+    herr_t ret = H5Sselect_none(_h(id_));
+    if (ret < 0) throw h5exception("Error in call to H5Sselect_none");
+    return true;
+}
+bool QH5Dataspace::selectHyperslab(const QVector<quint64>& offset,
+                                   const QVector<quint64>& count,
+                                   const QVector<quint64>& stride,
+                                   const QVector<quint64>& block,
+                                   SelectionOperator op) const
+{
+    if (!isValid()) return false;
+    int r = rank();
+    if (offset.size()!=r || count.size()!=r) return false;
+    if (!stride.isEmpty() && stride.size()!=r) return false;
+    if (!block.isEmpty() && block.size()!=r) return false;
+
+    H5S_seloper_t h5op;
+    switch (op)
+    {
+    case SELECT_OR:   h5op = H5S_SELECT_OR;   break;
+    case SELECT_AND:  h5op = H5S_SELECT_AND;  break;
+    case SELECT_XOR:  h5op = H5S_SELECT_XOR;  break;
+    case SELECT_NOTB: h5op = H5S_SELECT_NOTB; break;
+    case SELECT_NOTA: h5op = H5S_SELECT_NOTA; break;
+    default:          h5op = H5S_SELECT_SET;
+    }
+
+    herr_t ret = H5Sselect_hyperslab(_h(id_), h5op,
+                                     offset.constData(),
+                                     stride.isEmpty() ? NULL : stride.constData(),
+                                     count.constData(),
+                                     block.isEmpty() ? NULL : block.constData());
+    if (ret < 0) throw h5exception("Error in call to H5Sselect_hyperslab");
+    return true;
+}
+bool QH5Dataspace::selectElements(const QVector<quint64>& coords) const
+{
+    if (!isValid()) return false;
+    int r = rank();
+    if (r == 0 || coords.isEmpty() || coords.size() % r) return false;
+
+    herr_t ret = H5Sselect_elements(_h(id_), H5S_SELECT_SET,
+                                    coords.size() / r, coords.constData());
+    if (ret < 0) throw h5exception("Error in call to H5Sselect_elements");
+    return true;
+}
+quint64 QH5Dataspace::selectionSize() const
+{
+    if (!isValid()) return 0;
+    hssize_t s = H5Sget_select_npoints(_h(id_));
+    if (s < 0) throw h5exception("Error in call to H5Sget_select_npoints");
+    return s;
+}
+bool QH5Dataspace::selectionBounds(QVector<quint64>& start, QVector<quint64>& end) const
+{
+    if (!isValid() || selectionSize()==0) return false;
+    int r = rank();
+    start.resize(r);
+    end.resize(r);
+    herr_t ret = H5Sget_select_bounds(_h(id_), start.data(), end.data());
+    if (ret < 0) throw h5exception("Error in call to H5Sget_select_bounds");
+    return true;
+}
 /************* DATATYPE ***************/
 QH5Datatype QH5Datatype::fromMetaTypeId(int i)
 {
     QMetaType::Type metatype = static_cast<QMetaType::Type>(i);
 
-    if (metatype==QMetaType::QString) {
-        QH5Datatype datatype(H5Tcopy(H5T_C_S1),false);
-        datatype.setStringTraits(UTF8,H5T_VARIABLE);
-        return datatype;
-    }
+    if (metatype==QMetaType::QString)
+        return QH5Datatype(QH5Registry::instance().utf8String.id(),true);
 
     switch (metatype)
     {
     case QMetaType::Bool:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_HBOOL),false);
+        return QH5TypeMap<bool>::datatype();
     case QMetaType::Char:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_CHAR),false);
+        return QH5TypeMap<char>::datatype();
     case QMetaType::SChar:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_SCHAR),false);
+        return QH5TypeMap<signed char>::datatype();
     case QMetaType::UChar:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_UCHAR),false);
+        return QH5TypeMap<unsigned char>::datatype();
     case QMetaType::Short:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_SHORT),false);
+        return QH5TypeMap<short>::datatype();
     case QMetaType::UShort:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_USHORT),false);
+        return QH5TypeMap<unsigned short>::datatype();
     case QMetaType::Int:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_INT),false);
+        return QH5TypeMap<int>::datatype();
     case QMetaType::UInt:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_UINT),false);
+        return QH5TypeMap<unsigned int>::datatype();
     case QMetaType::Long:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_LONG),false);
+        return QH5TypeMap<long>::datatype();
     case QMetaType::ULong:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_ULONG),false);
+        return QH5TypeMap<unsigned long>::datatype();
     case QMetaType::LongLong:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_LLONG),false);
+        return QH5TypeMap<long long>::datatype();
     case QMetaType::ULongLong:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_ULLONG),false);
+        return QH5TypeMap<unsigned long long>::datatype();
 
     case QMetaType::Float:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_FLOAT),false);
+        return QH5TypeMap<float>::datatype();
     case QMetaType::Double:
-        return QH5Datatype(H5Tcopy(H5T_NATIVE_DOUBLE),false);
+        return QH5TypeMap<double>::datatype();
 
     default:
         return QH5Datatype();
@@ -233,24 +456,37 @@ int QH5Datatype::metaTypeId() const
         throw h5exception("Error in call to H5Tget_native_type");
         return QMetaType::UnknownType;
     }
-    if (id == H5T_NATIVE_CHAR)          return QMetaType::Char;
-    else if (id == H5T_NATIVE_SCHAR)    return QMetaType::SChar;
-    else if (id == H5T_NATIVE_SHORT)    return QMetaType::Short;
-    else if (id == H5T_NATIVE_INT)      return QMetaType::Int;
-    else if (id == H5T_NATIVE_LONG)     return QMetaType::Long;
-    else if (id == H5T_NATIVE_LLONG)    return QMetaType::LongLong;
-    else if (id == H5T_NATIVE_UCHAR)    return QMetaType::UChar;
-    else if (id == H5T_NATIVE_USHORT)   return QMetaType::UShort;
-    else if (id == H5T_NATIVE_UINT)     return QMetaType::UInt;
-    else if (id == H5T_NATIVE_ULONG)    return QMetaType::ULong;
-    else if (id == H5T_NATIVE_ULLONG)   return QMetaType::ULongLong;
-    else if (id == H5T_NATIVE_FLOAT)    return QMetaType::Float;
-    else if (id == H5T_NATIVE_DOUBLE)   return QMetaType::Double;
-    else if (id == H5T_NATIVE_B8)       return qMetaTypeId<quint8>();
-    else if (id == H5T_NATIVE_B16)      return qMetaTypeId<quint16>();
-    else if (id == H5T_NATIVE_B32)      return qMetaTypeId<quint32>();
-    else if (id == H5T_NATIVE_B64)      return qMetaTypeId<quint64>();
-    else return QMetaType::UnknownType;
+    QH5id native(static_cast<h5id>(id), false);
+
+    // H5Tget_native_type returns a copy, compare by value
+    const struct { hid_t t; int m; } natives[] = {
+        { H5T_NATIVE_CHAR,   QMetaType::Char },
+        { H5T_NATIVE_SCHAR,  QMetaType::SChar },
+        { H5T_NATIVE_SHORT,  QMetaType::Short },
+        { H5T_NATIVE_INT,    QMetaType::Int },
+        { H5T_NATIVE_LONG,   QMetaType::Long },
+        { H5T_NATIVE_LLONG,  QMetaType::LongLong },
+        { H5T_NATIVE_UCHAR,  QMetaType::UChar },
+        { H5T_NATIVE_USHORT, QMetaType::UShort },
+        { H5T_NATIVE_UINT,   QMetaType::UInt },
+        { H5T_NATIVE_ULONG,  QMetaType::ULong },
+        { H5T_NATIVE_ULLONG, QMetaType::ULongLong },
+        { H5T_NATIVE_FLOAT,  QMetaType::Float },
+        { H5T_NATIVE_DOUBLE, QMetaType::Double },
+        { H5T_NATIVE_B8,     qMetaTypeId<quint8>() },
+        { H5T_NATIVE_B16,    qMetaTypeId<quint16>() },
+        { H5T_NATIVE_B32,    qMetaTypeId<quint32>() },
+        { H5T_NATIVE_B64,    qMetaTypeId<quint64>() }
+    };
+    for(size_t i=0; i<sizeof(natives)/sizeof(natives[0]); ++i)
+        if (H5Tequal(id, natives[i].t) > 0) return natives[i].m;
+    return QMetaType::UnknownType;
+}
+QH5Datatype QH5Datatype::nativeType() const
+{
+    hid_t id = H5Tget_native_type(_h(id_), H5T_DIR_ASCEND);
+    if (id < 0) throw h5exception("Error in call to H5Tget_native_type");
+    return QH5Datatype(static_cast<h5id>(id),false);
 }
 QH5Datatype::Class QH5Datatype::getClass() const
 {
@@ -263,6 +499,10 @@ QH5Datatype::Class QH5Datatype::getClass() const
         return FLOAT;
     case H5T_STRING:
         return STRING;
+    case H5T_COMPOUND:
+        return COMPOUND;
+    case H5T_ARRAY:
+        return ARRAY;
     default:
         return UNSUPPORTED;
     }
@@ -303,6 +543,38 @@ size_t QH5Datatype::size() const
     if (s == 0) throw h5exception("H5Tget_size returns 0");
     return s;
 }
+QH5Datatype QH5Datatype::native(NativeType t)
+{
+    if (t < 0 || t >= NATIVE_TYPE_COUNT) return QH5Datatype();
+    return QH5Datatype(QH5Registry::instance().native[t].id(),true);
+}
+QH5Datatype QH5Datatype::copy() const
+{
+    if (!isValid()) return QH5Datatype();
+    hid_t id = H5Tcopy(_h(id_));
+    if (id < 0) throw h5exception("Error in call to H5Tcopy");
+    return QH5Datatype(static_cast<h5id>(id),false);
+}
+QH5Datatype QH5Datatype::compound(size_t size)
+{
+    hid_t id = H5Tcreate(H5T_COMPOUND, size);
+    if (id < 0) throw h5exception("Error in call to H5Tcreate");
+    return QH5Datatype(static_cast<h5id>(id),false);
+}
+bool QH5Datatype::insertMember(const char* name, size_t offset, const QH5Datatype& type) const
+{
+    if (getClass()!=COMPOUND || !type.isValid()) return false;
+    if (H5Tinsert(_h(id_), name, offset, _h(type)) < 0)
+        throw h5exception("Error in call to H5Tinsert");
+    return true;
+}
+QH5Datatype QH5Datatype::array(const QH5Datatype& base, const QVector<quint64>& dims)
+{
+    if (!base.isValid() || dims.isEmpty()) return QH5Datatype();
+    hid_t id = H5Tarray_create2(_h(base), dims.size(), dims.constData());
+    if (id < 0) throw h5exception("Error in call to H5Tarray_create2");
+    return QH5Datatype(static_cast<h5id>(id),false);
+}
 QH5Datatype QH5Datatype::fixedString(int size)
 {
     QH5Datatype datatype(H5Tcopy(H5T_C_S1),false);
@@ -345,7 +617,7 @@ QByteArrayList QH5Node::attributeNames() const
 bool QH5Node::readAttribute_(const char* name, void* data,
                       const QH5Datatype& memtype) const
 {
-    if (!data || !memtype.isValid()) return false;
+    if (!data || memtype.isNull()) return false;
 
     QH5id attr = openAttribute_(name,memtype,false);
     if (attr.id()) {
@@ -356,7 +628,7 @@ bool QH5Node::readAttribute_(const char* name, void* data,
 }
 bool QH5Node::readAttribute_(const char* name, QString& str) const
 {
-    QH5Dataspace memspace = QH5Dataspace::scalar();
+    const QH5id& memspace = QH5Registry::instance().scalarSpace;
     QH5id attr = openAttribute_(name,QH5Datatype(),false);
     if (! attr.id()) return false;
     QH5Datatype filetype(H5Aget_type (attr.id()), false);
@@ -386,7 +658,7 @@ bool QH5Node::readAttribute_(const char* name, QString& str) const
 bool QH5Node::writeAttribute_(const char* name, const void* data,
                        const QH5Datatype& memtype) const
 {
-    if (!data || !memtype.isValid()) return false;
+    if (!data || memtype.isNull()) return false;
 
     QH5id attr = openAttribute_(name,memtype,true);
     if (attr.id()) {
@@ -416,20 +688,206 @@ QH5id QH5Node::openAttribute_(const char* name, const QH5Datatype& memtype, bool
     } else if (create) {
         attr = H5Acreate_by_name(_h(id_), ".", name,
                                  _h(memtype.id()),
-                                 _h(QH5Dataspace::scalar().id()),
+                                 _h(QH5Registry::instance().scalarSpace),
                                  H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
         if (attr < 0) throw h5exception("H5Acreate_by_name");
     }
     return QH5id(static_cast<h5id>(attr),false);
 }
+/*********** CHUNK CACHE ************/
+const size_t QH5ChunkCache::DEFAULT;
+
+QH5ChunkCache QH5ChunkCache::forChunks(size_t nchunks, size_t chunkBytes, double preemption)
+{
+    if (!nchunks) nchunks = 1;
+    // find a prime > 100*nchunks
+    size_t n = 100*nchunks + 1;
+    for(;; n += 2) {
+        bool prime = true;
+        for(size_t d = 3; d*d <= n; d += 2) if (n % d == 0) { prime = false; break; }
+        if (prime) break;
+    }
+    return QH5ChunkCache(n, nchunks*chunkBytes, preemption);
+}
+/*********** DATASET ACCESS OPTIONS ************/
+QH5id QH5DatasetAccessOptions::createPlist() const
+{
+    if (cache_.isDefault()) return QH5id();
+
+    hid_t pid = H5Pcreate(H5P_DATASET_ACCESS);
+    if (pid < 0) throw h5exception("Error in call to H5Pcreate");
+    QH5id plist(static_cast<QH5id::h5id>(pid), false);
+
+    size_t nslots = cache_.nslots==QH5ChunkCache::DEFAULT ?
+                H5D_CHUNK_CACHE_NSLOTS_DEFAULT : cache_.nslots;
+    size_t bytes = cache_.bytes==QH5ChunkCache::DEFAULT ?
+                H5D_CHUNK_CACHE_NBYTES_DEFAULT : cache_.bytes;
+    double w0 = cache_.w0 < 0 ? H5D_CHUNK_CACHE_W0_DEFAULT : cache_.w0;
+    if (H5Pset_chunk_cache(pid, nslots, bytes, w0) < 0)
+        throw h5exception("Error in call to H5Pset_chunk_cache");
+
+    return plist;
+}
+/*********** DATASET CREATE OPTIONS ************/
+QVector<quint64> QH5DatasetCreateOptions::defaultChunk(const QVector<quint64>& dims,
+                                                       const QVector<quint64>& maxdims,
+                                                       size_t typeSize)
+{
+    // aim at chunks that fit comfortably in the default 1MB chunk cache
+    const quint64 target = 256*1024;
+
+    QVector<quint64> chunk(dims);
+    quint64 n = typeSize ? typeSize : 1;
+    for(int i=0; i<chunk.size(); ++i) {
+        // unlimited dimensions start large and are reduced below
+        if (maxdims[i]==QH5Dataspace::UNLIMITED) chunk[i] = qMax(chunk[i], target);
+        else chunk[i] = maxdims[i];
+        if (chunk[i]==0) chunk[i] = 1;
+        n *= chunk[i];
+    }
+    // halve the dimensions in turn until the chunk is small enough
+    int i = 0, nunchanged = 0;
+    while (n > target && nunchanged < chunk.size()) {
+        if (chunk[i] > 1) {
+            n /= chunk[i];
+            chunk[i] = (chunk[i]+1)/2;
+            n *= chunk[i];
+            nunchanged = 0;
+        } else nunchanged++;
+        i = (i+1) % chunk.size();
+    }
+    return chunk;
+}
+bool QH5DatasetCreateOptions::createPlist(const QH5Dataspace& dataspace,
+                                          const QH5Datatype& datatype,
+                                          QH5id& plist) const
+{
+    plist = QH5id();
+
+    bool chunked = (isChunked() || dataspace.isExtendible()) && dataspace.isValid() &&
+            H5Sget_simple_extent_type(_h(dataspace)) == H5S_SIMPLE;
+
+    if (!chunked && !hasFillValue() && allocTime_==ALLOC_DEFAULT)
+        return true;
+
+    hid_t pid = H5Pcreate(H5P_DATASET_CREATE);
+    if (pid < 0) throw h5exception("Error in call to H5Pcreate");
+    plist = QH5id(static_cast<QH5id::h5id>(pid), false);
+
+    if (chunked) {
+        QVector<quint64> dims = dataspace.dimensions();
+        QVector<quint64> cdims = chunk_.isEmpty() ?
+                    defaultChunk(dims, dataspace.maxDimensions(), datatype.size()) : chunk_;
+        if (cdims.size() != dims.size()) return false;
+        if (H5Pset_chunk(pid, cdims.size(), cdims.constData()) < 0)
+            throw h5exception("Error in call to H5Pset_chunk");
+
+        if (nbit_ && H5Pset_nbit(pid) < 0)
+            throw h5exception("Error in call to H5Pset_nbit");
+        if (scaleOffset_) {
+            H5Z_SO_scale_type_t t = scaleType_==SCALE_FLOAT_DSCALE ? H5Z_SO_FLOAT_DSCALE :
+                                    scaleType_==SCALE_FLOAT_ESCALE ? H5Z_SO_FLOAT_ESCALE :
+                                                                     H5Z_SO_INT;
+            if (H5Pset_scaleoffset(pid, t, scaleFactor_) < 0)
+                throw h5exception("Error in call to H5Pset_scaleoffset");
+        }
+        if (shuffle_ && H5Pset_shuffle(pid) < 0)
+            throw h5exception("Error in call to H5Pset_shuffle");
+        if (deflate_ >= 0 && H5Pset_deflate(pid, deflate_) < 0)
+            throw h5exception("Error in call to H5Pset_deflate");
+        if (fletcher32_ && H5Pset_fletcher32(pid) < 0)
+            throw h5exception("Error in call to H5Pset_fletcher32");
+    }
+
+    if (hasFillValue() &&
+            H5Pset_fill_value(pid, _h(fillType_), fillValue_.constData()) < 0)
+        throw h5exception("Error in call to H5Pset_fill_value");
+
+    if (allocTime_ != ALLOC_DEFAULT) {
+        H5D_alloc_time_t t = allocTime_==ALLOC_EARLY ? H5D_ALLOC_TIME_EARLY :
+                             allocTime_==ALLOC_INCR ? H5D_ALLOC_TIME_INCR :
+                                                      H5D_ALLOC_TIME_LATE;
+        if (H5Pset_alloc_time(pid, t) < 0)
+            throw h5exception("Error in call to H5Pset_alloc_time");
+    }
+
+    return true;
+}
+QH5DatasetCreateOptions QH5DatasetCreateOptions::fromPlist(const QH5id& plist)
+{
+    QH5DatasetCreateOptions opt;
+    hid_t pid = _h(plist);
+
+    if (H5Pget_layout(pid) == H5D_CHUNKED) {
+        int r = H5Pget_chunk(pid, 0, NULL);
+        if (r < 0) throw h5exception("Error in call to H5Pget_chunk");
+        opt.chunk_.resize(r);
+        H5Pget_chunk(pid, r, opt.chunk_.data());
+    }
+
+    int nfilters = H5Pget_nfilters(pid);
+    for(int i=0; i<nfilters; ++i) {
+        unsigned int flags;
+        size_t nelmts = 8;
+        unsigned int cd_values[8];
+        unsigned int config;
+        H5Z_filter_t filter = H5Pget_filter2(pid, i, &flags, &nelmts, cd_values,
+                                             0, NULL, &config);
+        switch (filter)
+        {
+        case H5Z_FILTER_DEFLATE:
+            opt.deflate_ = nelmts ? cd_values[0] : 6;
+            break;
+        case H5Z_FILTER_SHUFFLE:
+            opt.shuffle_ = true;
+            break;
+        case H5Z_FILTER_FLETCHER32:
+            opt.fletcher32_ = true;
+            break;
+        case H5Z_FILTER_NBIT:
+            opt.nbit_ = true;
+            break;
+        case H5Z_FILTER_SCALEOFFSET:
+            opt.scaleOffset_ = true;
+            if (nelmts > 1) {
+                opt.scaleType_ = cd_values[0]==H5Z_SO_FLOAT_DSCALE ? SCALE_FLOAT_DSCALE :
+                                 cd_values[0]==H5Z_SO_FLOAT_ESCALE ? SCALE_FLOAT_ESCALE :
+                                                                     SCALE_INT;
+                opt.scaleFactor_ = cd_values[1];
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    H5D_alloc_time_t t;
+    if (H5Pget_alloc_time(pid, &t) >= 0) {
+        opt.allocTime_ = t==H5D_ALLOC_TIME_EARLY ? ALLOC_EARLY :
+                         t==H5D_ALLOC_TIME_INCR ? ALLOC_INCR :
+                         t==H5D_ALLOC_TIME_LATE ? ALLOC_LATE : ALLOC_DEFAULT;
+    }
+
+    return opt;
+}
 /*********** DATASET ************/
+/*
+ * A null filespace stands for the whole dataset (H5S_ALL)
+ */
+hid_t _filespace(const QH5Dataspace& filespace)
+{
+    return filespace.isNull() ? H5S_ALL : _h(filespace);
+}
 bool QH5Dataset::write_(const void* data, const QH5Dataspace& memspace,
-                       const QH5Datatype& memtype) const
+                       const QH5Datatype& memtype,
+                       const QH5Dataspace& filespace) const
 {
-    if (!data || !memspace.isValid() || !memtype.isValid()) return false;
+    if (!data || memspace.isNull() || memtype.isNull()) return false;
+    if (!filespace.isNull() && filespace.selectionSize()!=memspace.selectionSize())
+        return false;
 
     herr_t ret = H5Dwrite (_h(id_), _h(memtype.id()), _h(memspace.id()),
-                     H5S_ALL, H5P_DEFAULT, data);
+                     _filespace(filespace), H5P_DEFAULT, data);
 
     if (ret<0) throw h5exception("Error in call to H5Dwrite");
 
@@ -468,13 +926,16 @@ bool QH5Dataset::write_(const QString &str, const QH5Dataspace &memspace, const
     return true;
 
 }
-bool QH5Dataset::write_(const QStringList& str) const
+bool QH5Dataset::write_(const QStringList& str, const QH5Dataspace &filespace) const
 {
-    return write_(str, QH5Dataspace(QVector<quint64> (1,str.size())), datatype());
+    return write_(str, QH5Dataspace(QVector<quint64> (1,str.size())), datatype(), filespace);
 }
-bool QH5Dataset::write_(const QStringList& str, const QH5Dataspace &memspace, const QH5Datatype &memtype) const
+bool QH5Dataset::write_(const QStringList& str, const QH5Dataspace &memspace, const QH5Datatype &memtype,
+                        const QH5Dataspace &filespace) const
 {
     if (memtype.getClass() != QH5Datatype::STRING) return false;
+    if (!filespace.isNull() && filespace.selectionSize()!=memspace.selectionSize())
+        return false;
     size_t sz;
     QH5Datatype::StringEncoding enc;
     memtype.getStringTraits(enc,sz);
@@ -488,7 +949,7 @@ bool QH5Dataset::write_(const QStringList& str, const QH5Dataspace &memspace, co
             vbuff[i++] = ba.last().data();
         }
         ret = H5Dwrite (_h(id_), _h(memtype.id()), _h(memspace.id()),
-                         H5S_ALL, H5P_DEFAULT, vbuff.data());
+                         _filespace(filespace), H5P_DEFAULT, vbuff.data());
 
     } else {
         QByteArray buff((int)sz*str.size(),'\0');
@@ -503,18 +964,22 @@ bool QH5Dataset::write_(const QStringList& str, const QH5Dataspace &memspace, co
             p += sz;
         }
         ret = H5Dwrite (_h(id_), _h(memtype.id()), _h(memspace.id()),
-                         H5S_ALL, H5P_DEFAULT, buff.constData());
+                         _filespace(filespace), H5P_DEFAULT, buff.constData());
     }
     if (ret < 0) throw h5exception("Error in call to H5Dwrite");
     return true;
 }
 bool QH5Dataset::read_(void* data, const QH5Dataspace &memspace,
-                      const QH5Datatype& memtype) const
+                      const QH5Datatype& memtype,
+                      const QH5Dataspace &filespace) const
 {
-    if (!data || !memspace.isValid() || !memtype.isValid()) return false;
+    if (!filespace.isNull() && filespace.selectionSize()==0) return true;
+    if (!data || memspace.isNull() || memtype.isNull()) return false;
+    if (!filespace.isNull() && filespace.selectionSize()!=memspace.selectionSize())
+        return false;
 
     herr_t ret = H5Dread (_h(id_), _h(memtype.id()), _h(memspace.id()),
-                    H5S_ALL, H5P_DEFAULT, data);
+                    _filespace(filespace), H5P_DEFAULT, data);
 
     if (ret < 0) throw h5exception("Error in call to H5Dread");
     return true;
@@ -548,14 +1013,22 @@ bool QH5Dataset::read_(QString& str) const
     }
     return true;
 }
-bool QH5Dataset::read_(QStringList& str) const
+bool QH5Dataset::read_(QStringList& str, const QH5Dataspace &filespace) const
 {
-    QH5Dataspace ds = dataspace();
-    QVector<quint64> dims = ds.dimensions();
-    if (dims.size()>1) {
-        return false;
+    QH5Dataspace ds;
+    int n;
+    if (!filespace.isNull()) {
+        n = filespace.selectionSize();
+        if (n==0) return true;
+        ds = QH5Dataspace(QVector<quint64>(1,n));
+    } else {
+        ds = dataspace();
+        QVector<quint64> dims = ds.dimensions();
+        if (dims.size()>1) {
+            return false;
+        }
+        n = dims[0];
     }
-    int n = dims[0];
     QH5Datatype filetype = datatype();
     if (filetype.getClass() != QH5Datatype::STRING) return false;
     size_t sz;
@@ -565,7 +1038,7 @@ bool QH5Dataset::read_(QStringList& str) const
     if (sz==H5T_VARIABLE) {
         QVector<char*> p(n);
         herr_t ret =  H5Dread (_h(id_), _h(filetype.id()), _h(ds.id()),
-                         H5S_ALL, H5P_DEFAULT, p.data());
+                         _filespace(filespace), H5P_DEFAULT, p.data());
         if (ret < 0) throw h5exception("Error in call to H5Dread");
         for(int i = 0; i<n; i++) {
             QString s = (enc==QH5Datatype::ASCII) ? QString::fromLatin1(p[i]) :
@@ -578,7 +1051,7 @@ bool QH5Dataset::read_(QStringList& str) const
         QByteArray buff((int)sz*n,'\0');
 
         herr_t ret = H5Dread (_h(id_), _h(filetype.id()), _h(ds.id()),
-                         H5S_ALL, H5P_DEFAULT, buff.data());
+                         _filespace(filespace), H5P_DEFAULT, buff.data());
         if (ret < 0) throw h5exception("Error in call to H5Dread");
 
         const char* p = buff.data();
@@ -603,13 +1076,247 @@ QH5Dataspace QH5Dataset::dataspace() const
     if (id < 0) throw h5exception("Error in call to H5Dget_type");
     return QH5Dataspace(static_cast<h5id>(id),false);
 }
+QH5DatasetCreateOptions QH5Dataset::createOptions() const
+{
+    hid_t id = H5Dget_create_plist(_h(id_));
+    if (id < 0) throw h5exception("Error in call to H5Dget_create_plist");
+    return QH5DatasetCreateOptions::fromPlist(QH5id(static_cast<h5id>(id),false));
+}
+QH5ChunkCache QH5Dataset::chunkCache() const
+{
+    hid_t pid = H5Dget_access_plist(_h(id_));
+    if (pid < 0) throw h5exception("Error in call to H5Dget_access_plist");
+    QH5id plist(static_cast<h5id>(pid), false);
+
+    QH5ChunkCache c;
+    if (H5Pget_chunk_cache(pid, &c.nslots, &c.bytes, &c.w0) < 0)
+        throw h5exception("Error in call to H5Pget_chunk_cache");
+    return c;
+}
+bool QH5Dataset::setExtent(const QVector<quint64>& dims) const
+{
+    if (!isValid() || dims.size()!=dataspace().rank()) return false;
+    herr_t ret = H5Dset_extent(_h(id_), dims.constData());
+    if (ret < 0) throw h5exception("Error in call to H5Dset_extent");
+    return true;
+}
+bool QH5Dataset::append_(const void* data, quint64 n, const QH5Datatype& memtype) const
+{
+    if (!data || memtype.isNull()) return false;
+
+    QVector<quint64> dims = dataspace().dimensions();
+    if (dims.isEmpty()) return false;
+
+    // number of elements in a record
+    quint64 m = 1;
+    for(int i=1; i<dims.size(); ++i) m *= dims[i];
+    if (m==0 || n % m) return false;
+
+    QVector<quint64> offset(dims.size(),0), count(dims);
+    offset[0] = dims[0];
+    count[0] = n/m;
+    dims[0] += count[0];
+    if (!setExtent(dims)) return false;
+
+    QH5Dataspace filespace = dataspace();
+    filespace.selectHyperslab(offset,count);
+    QH5Dataspace memspace(QVector<quint64>(1,n));
+
+    herr_t ret = H5Dwrite (_h(id_), _h(memtype.id()), _h(memspace.id()),
+                           _h(filespace.id()), H5P_DEFAULT, data);
+    if (ret < 0) throw h5exception("Error in call to H5Dwrite");
+    return true;
+}
+bool QH5Dataset::writeChunk(const QVector<quint64>& offset, quint32 filterMask,
+                            const QByteArray& data) const
+{
+#if H5_VERSION_GE(1,10,5)
+    if (!isValid() || data.isEmpty() || offset.size()!=dataspace().rank()) return false;
+    herr_t ret = H5Dwrite_chunk(_h(id_), H5P_DEFAULT, filterMask,
+                                offset.constData(), data.size(), data.constData());
+    if (ret < 0) throw h5exception("Error in call to H5Dwrite_chunk");
+    return true;
+#else
+    Q_UNUSED(offset) Q_UNUSED(filterMask) Q_UNUSED(data)
+    return false;
+#endif
+}
+QByteArray QH5Dataset::readChunk(const QVector<quint64>& offset, quint32* filterMask) const
+{
+#if H5_VERSION_GE(1,10,5)
+    QH5ChunkInfo info;
+    if (!chunkInfo(offset, info)) return QByteArray();
+
+    QByteArray data(info.size, '\0');
+    uint32_t mask;
+    herr_t ret = H5Dread_chunk(_h(id_), H5P_DEFAULT, offset.constData(), &mask, data.data());
+    if (ret < 0) throw h5exception("Error in call to H5Dread_chunk");
+    if (filterMask) *filterMask = mask;
+    return data;
+#else
+    Q_UNUSED(offset) Q_UNUSED(filterMask)
+    return QByteArray();
+#endif
+}
+quint64 QH5Dataset::chunkCount() const
+{
+#if H5_VERSION_GE(1,10,5)
+    if (!isValid() || createOptions().chunk().isEmpty()) return 0;
+    QH5Dataspace fspace = dataspace();
+    hsize_t n;
+    if (H5Dget_num_chunks(_h(id_), _h(fspace), &n) < 0)
+        throw h5exception("Error in call to H5Dget_num_chunks");
+    return n;
+#else
+    return 0;
+#endif
+}
+bool QH5Dataset::chunkInfo(const QVector<quint64>& offset, QH5ChunkInfo& info) const
+{
+#if H5_VERSION_GE(1,10,5)
+    if (!isValid() || offset.size()!=dataspace().rank()) return false;
+    unsigned mask;
+    haddr_t addr;
+    hsize_t size;
+    if (H5Dget_chunk_info_by_coord(_h(id_), offset.constData(), &mask, &addr, &size) < 0)
+        throw h5exception("Error in call to H5Dget_chunk_info_by_coord");
+    if (addr == HADDR_UNDEF) return false;
+    info.offset = offset;
+    info.filterMask = mask;
+    info.address = addr;
+    info.size = size;
+    return true;
+#else
+    Q_UNUSED(offset) Q_UNUSED(info)
+    return false;
+#endif
+}
+QVector<QH5ChunkInfo> QH5Dataset::chunks() const
+{
+    QVector<QH5ChunkInfo> list;
+    QVector<quint64> cdims = createOptions().chunk();
+    QVector<quint64> dims = dataspace().dimensions();
+    if (cdims.isEmpty() || cdims.size()!=dims.size()) return list;
+    for(int i=0; i<dims.size(); ++i) if (dims[i]==0) return list;
+
+    // walk the chunk grid in row-major order
+    QVector<quint64> offset(dims.size(),0);
+    QH5ChunkInfo info;
+    forever {
+        if (chunkInfo(offset, info)) list.push_back(info);
+        int i = dims.size()-1;
+        for(; i>=0; --i) {
+            offset[i] += cdims[i];
+            if (offset[i] < dims[i]) break;
+            offset[i] = 0;
+        }
+        if (i < 0) break;
+    }
+    return list;
+}
+bool QH5Dataset::copyChunksFrom(const QH5Dataset& src) const
+{
+    if (!isValid() || !src.isValid()) return false;
+
+    QH5DatasetCreateOptions a = createOptions(), b = src.createOptions();
+    if (a.chunk().isEmpty() || a.chunk()!=b.chunk() ||
+            a.deflate()!=b.deflate() || a.shuffle()!=b.shuffle() ||
+            a.fletcher32()!=b.fletcher32() || a.nbit()!=b.nbit() ||
+            a.scaleOffset()!=b.scaleOffset()) return false;
+    if (H5Tequal(_h(datatype()), _h(src.datatype())) <= 0) return false;
+
+    // grow only, never drop data of this dataset
+    QVector<quint64> dims = dataspace().dimensions(), sdims = src.dataspace().dimensions();
+    if (dims.size()!=sdims.size()) return false;
+    bool grow = false;
+    for(int i=0; i<dims.size(); ++i)
+        if (sdims[i] > dims[i]) {
+            dims[i] = sdims[i];
+            grow = true;
+        }
+    if (grow && !setExtent(dims)) return false;
+
+    QVector<QH5ChunkInfo> list = src.chunks();
+    for(int i=0; i<list.size(); ++i) {
+        quint32 mask;
+        QByteArray data = src.readChunk(list[i].offset, &mask);
+        if (!writeChunk(list[i].offset, mask, data)) return false;
+    }
+    return true;
+}
+bool QH5Dataset::refresh() const
+{
+    if (!isValid()) return false;
+    herr_t ret = H5Drefresh(_h(id_));
+    if (ret < 0) throw h5exception("Error in call to H5Drefresh");
+    return true;
+}
+bool QH5Dataset::flush() const
+{
+    if (!isValid()) return false;
+    herr_t ret = H5Dflush(_h(id_));
+    if (ret < 0) throw h5exception("Error in call to H5Dflush");
+    return true;
+}
+quint64 QH5Dataset::storageSize() const
+{
+    return H5Dget_storage_size(_h(id_));
+}
 /*********** FILE ************/
+/*
+ * LRU cache of open group/dataset handles of a QH5File, keyed by normalized path.
+ * Shared by copies of the QH5File object.
+ */
+struct QH5HandleCache
+{
+    struct Entry {
+        QH5Group group;
+        QH5Dataset dataset;
+    };
+
+    QMutex mutex;
+    QCache<QByteArray, Entry> cache;
+
+    explicit QH5HandleCache(int n) : cache(n) {}
+};
+
+// remove leading and trailing '/', also used by QH5FileIndex
+QByteArray _normalizedPath(const QByteArray& path)
+{
+    int i = 0, j = path.size();
+    while (i < j && path[i] == '/') ++i;
+    while (j > i && path[j-1] == '/') --j;
+    return path.mid(i, j - i);
+}
+
+// open any object by path, without error output if it does not exist
+static hid_t _openObject(hid_t loc, const QByteArray& path)
+{
+    hid_t oid;
+    H5E_BEGIN_TRY {
+        oid = H5Oopen(loc, path.constData(), H5P_DEFAULT);
+    } H5E_END_TRY;
+    return oid;
+}
+
 bool QH5File::isHDF5(const QString& fname)
 {
     return H5Fis_hdf5 (fname.toLatin1()) > 0;
 }
 
-bool QH5File::open(QIODevice::OpenMode mode)
+bool QH5File::isThreadSafe()
+{
+#if H5_VERSION_GE(1,8,16)
+    hbool_t threadsafe = 0;
+    return H5is_library_threadsafe(&threadsafe) >= 0 && threadsafe;
+#elif defined(H5_HAVE_THREADSAFE)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool QH5File::open(QIODevice::OpenMode mode, bool swmr)
 {
     if (isOpen()) {
         error_msg_ = QString("The file '%1' is already open").arg(fname_);
@@ -623,10 +1330,13 @@ bool QH5File::open(QIODevice::OpenMode mode)
 
     bool bExists = QFile::exists(fname_);
 
+    QH5id fapl = accessPlist(swmr);
+    hid_t fapl_id = fapl.id() ? _h(fapl) : H5P_DEFAULT;
+
     hid_t fid;
     if ( !bExists || (bExists && mode.testFlag(QIODevice::Truncate)))
         fid = H5Fcreate (fname_.toLatin1(),
-                         H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+                         H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
     else {
         if (!isHDF5(fname_)) {
             error_msg_ = QString("The file %1 is not in the HDF5 format").arg(fname_);
@@ -636,7 +1346,8 @@ bool QH5File::open(QIODevice::OpenMode mode)
         unsigned int flags = H5F_ACC_RDWR;
         if (mode.testFlag(QIODevice::ReadOnly) && !mode.testFlag(QIODevice::WriteOnly))
             flags = H5F_ACC_RDONLY;
-        fid = H5Fopen (fname_.toLatin1(), flags, H5P_DEFAULT);
+        if (swmr) flags |= (flags==H5F_ACC_RDONLY) ? H5F_ACC_SWMR_READ : H5F_ACC_SWMR_WRITE;
+        fid = H5Fopen (fname_.toLatin1(), flags, fapl_id);
     }
 
     if (fid < 0) {
@@ -644,10 +1355,207 @@ bool QH5File::open(QIODevice::OpenMode mode)
         return false;
     } else {
         id_ = QH5id(_h(fid), false); // create id obj with refcount = 1
+        if (handleCacheSize_)
+            handles_ = QSharedPointer<QH5HandleCache>(new QH5HandleCache(handleCacheSize_));
     }
 
     return id_.isValid();
 }
+QH5id QH5File::accessPlist(bool swmr) const
+{
+    if (!swmr && !core_ && chunkCache_.isDefault()) return QH5id();
+
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    if (fapl < 0) throw h5exception("Error in call to H5Pcreate");
+    QH5id plist(static_cast<QH5id::h5id>(fapl), false);
+
+    // SWMR requires the latest file format
+    if (swmr && H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST) < 0)
+        throw h5exception("Error in call to H5Pset_libver_bounds");
+
+    if (core_ && H5Pset_fapl_core(fapl, coreIncrement_, coreBackingStore_) < 0)
+        throw h5exception("Error in call to H5Pset_fapl_core");
+
+    if (!chunkCache_.isDefault()) {
+        // start from the current defaults, the mdc_nelmts argument is ignored
+        int mdc;
+        size_t nslots, bytes;
+        double w0;
+        if (H5Pget_cache(fapl, &mdc, &nslots, &bytes, &w0) < 0)
+            throw h5exception("Error in call to H5Pget_cache");
+        if (chunkCache_.nslots != QH5ChunkCache::DEFAULT) nslots = chunkCache_.nslots;
+        if (chunkCache_.bytes != QH5ChunkCache::DEFAULT) bytes = chunkCache_.bytes;
+        if (chunkCache_.w0 >= 0) w0 = chunkCache_.w0;
+        if (H5Pset_cache(fapl, mdc, nslots, bytes, w0) < 0)
+            throw h5exception("Error in call to H5Pset_cache");
+    }
+
+    return plist;
+}
+QH5ChunkCache QH5File::chunkCache() const
+{
+    if (!isOpen()) return chunkCache_;
+
+    hid_t fapl = H5Fget_access_plist(_h(id_));
+    if (fapl < 0) throw h5exception("Error in call to H5Fget_access_plist");
+    QH5id plist(static_cast<QH5id::h5id>(fapl), false);
+
+    int mdc;
+    QH5ChunkCache c;
+    if (H5Pget_cache(fapl, &mdc, &c.nslots, &c.bytes, &c.w0) < 0)
+        throw h5exception("Error in call to H5Pget_cache");
+    return c;
+}
+QH5File::CacheStatistics QH5File::cacheStatistics(bool reset) const
+{
+    CacheStatistics st;
+    memset(&st, 0, sizeof(st));
+    if (!isOpen()) return st;
+
+    if (H5Fget_mdc_hit_rate(_h(id_), &st.metadataHitRate) < 0)
+        throw h5exception("Error in call to H5Fget_mdc_hit_rate");
+    size_t minCleanSize;
+    if (H5Fget_mdc_size(_h(id_), &st.metadataMaxSize, &minCleanSize,
+                        &st.metadataCurrentSize, &st.metadataEntries) < 0)
+        throw h5exception("Error in call to H5Fget_mdc_size");
+    if (reset && H5Freset_mdc_hit_rate_stats(_h(id_)) < 0)
+        throw h5exception("Error in call to H5Freset_mdc_hit_rate_stats");
+    return st;
+}
+QByteArray QH5File::toImage() const
+{
+    if (!isOpen()) return QByteArray();
+
+    if (H5Fflush(_h(id_), H5F_SCOPE_GLOBAL) < 0)
+        throw h5exception("Error in call to H5Fflush");
+
+    ssize_t sz = H5Fget_file_image(_h(id_), NULL, 0);
+    if (sz < 0) throw h5exception("Error in call to H5Fget_file_image");
+
+    QByteArray image(sz, '\0');
+    if (H5Fget_file_image(_h(id_), image.data(), sz) < 0)
+        throw h5exception("Error in call to H5Fget_file_image");
+    return image;
+}
+QH5File QH5File::fromImage(const QByteArray& image, bool writable)
+{
+    // a unique name, so that HDF5 does not confuse different images
+    static QAtomicInt counter;
+    QH5File f(QString("qthdf5-image-%1").arg(counter.fetchAndAddRelaxed(1)));
+    f.core_ = true;
+
+    if (image.isEmpty()) {
+        f.error_msg_ = QString("The file image is empty");
+        return f;
+    }
+
+    QH5id fapl = f.accessPlist(false);
+    if (H5Pset_file_image(_h(fapl), const_cast<char*>(image.constData()), image.size()) < 0)
+        throw h5exception("Error in call to H5Pset_file_image");
+
+    hid_t fid = H5Fopen(f.fname_.toLatin1(), writable ? H5F_ACC_RDWR : H5F_ACC_RDONLY, _h(fapl));
+    if (fid < 0) f.error_msg_ = QString("The image is not a valid HDF5 file");
+    else {
+        f.id_ = QH5id(static_cast<QH5id::h5id>(fid), false);
+        if (f.handleCacheSize_)
+            f.handles_ = QSharedPointer<QH5HandleCache>(new QH5HandleCache(f.handleCacheSize_));
+    }
+
+    return f;
+}
+bool QH5File::startSwmrWrite()
+{
+    if (!isOpen()) return false;
+    herr_t ret = H5Fstart_swmr_write(_h(id_));
+    if (ret < 0) throw h5exception("Error in call to H5Fstart_swmr_write");
+    return true;
+}
+bool QH5File::isSwmr() const
+{
+    if (!isOpen()) return false;
+    unsigned int intent;
+    if (H5Fget_intent(_h(id_), &intent) < 0)
+        throw h5exception("Error in call to H5Fget_intent");
+    return (intent & (H5F_ACC_SWMR_READ | H5F_ACC_SWMR_WRITE)) != 0;
+}
+bool QH5File::flush() const
+{
+    if (!isOpen()) return false;
+    herr_t ret = H5Fflush(_h(id_), H5F_SCOPE_GLOBAL);
+    if (ret < 0) throw h5exception("Error in call to H5Fflush");
+    return true;
+}
+bool QH5File::close()
+{
+    clearHandleCache();
+    handles_.clear();
+    return id_.close();
+}
+void QH5File::clearHandleCache() const
+{
+    if (!handles_) return;
+    QMutexLocker lock(&handles_->mutex);
+    handles_->cache.clear();
+}
+void QH5File::openCached_(const QByteArray& path, bool createGroup,
+                          QH5Group& g, QH5Dataset& ds) const
+{
+    if (!isOpen()) return;
+
+    QByteArray key = _normalizedPath(path);
+    if (key.isEmpty()) {
+        g = root();
+        return;
+    }
+
+    if (handles_) {
+        QMutexLocker lock(&handles_->mutex);
+        if (QH5HandleCache::Entry* e = handles_->cache.object(key)) {
+            g = e->group;
+            ds = e->dataset;
+            return;
+        }
+    }
+
+    hid_t oid = _openObject(_h(id_), key);
+    if (oid < 0) {
+        if (!createGroup) return;
+        oid = H5Gcreate(_h(id_), key.constData(),
+                        _h(QH5Registry::instance().lcplIntermediate), H5P_DEFAULT, H5P_DEFAULT);
+        if (oid < 0) throw h5exception("Error in call to H5Gcreate");
+    }
+
+    switch (H5Iget_type(oid))
+    {
+    case H5I_GROUP: g = QH5Group(static_cast<QH5id::h5id>(oid), false); break;
+    case H5I_DATASET: ds = QH5Dataset(static_cast<QH5id::h5id>(oid), false); break;
+    default:
+        H5Oclose(oid);
+        return;
+    }
+
+    if (handles_) {
+        QH5HandleCache::Entry* e = new QH5HandleCache::Entry;
+        e->group = g;
+        e->dataset = ds;
+        QMutexLocker lock(&handles_->mutex);
+        handles_->cache.insert(key, e);
+    }
+}
+QH5Group QH5File::group(const QByteArray& path, bool create) const
+{
+    QH5Group g;
+    QH5Dataset ds;
+    openCached_(path, create, g, ds);
+    return g;
+}
+QH5Dataset QH5File::dataset(const QByteArray& path) const
+{
+    QH5Group g;
+    QH5Dataset ds;
+    openCached_(path, false, g, ds);
+    return ds;
+}
 QH5Group QH5File::root() const
 {
     if (!isOpen()) return QH5Group();
@@ -655,6 +1563,45 @@ QH5Group QH5File::root() const
     return QH5Group(static_cast<QH5id::h5id>(gid), false);
 }
 /********** GROUP *****************/
+/*
+ * Type of the object linked by name, without opening it.
+ * Only the basic object header fields are retrieved where supported.
+ * Dangling soft and external links are reported as QH5Node::UNKNOWN.
+ */
+static QH5Node::Type _objectType(hid_t loc, const char* name, bool hardLink = true)
+{
+    herr_t ret;
+#if H5_VERSION_GE(1,12,0)
+    H5O_info2_t info;
+    if (hardLink) ret = H5Oget_info_by_name3(loc, name, &info, H5O_INFO_BASIC, H5P_DEFAULT);
+    else H5E_BEGIN_TRY {
+        ret = H5Oget_info_by_name3(loc, name, &info, H5O_INFO_BASIC, H5P_DEFAULT);
+    } H5E_END_TRY;
+#elif H5_VERSION_GE(1,10,3)
+    H5O_info_t info;
+    if (hardLink) ret = H5Oget_info_by_name2(loc, name, &info, H5O_INFO_BASIC, H5P_DEFAULT);
+    else H5E_BEGIN_TRY {
+        ret = H5Oget_info_by_name2(loc, name, &info, H5O_INFO_BASIC, H5P_DEFAULT);
+    } H5E_END_TRY;
+#else
+    H5O_info_t info;
+    if (hardLink) ret = H5Oget_info_by_name(loc, name, &info, H5P_DEFAULT);
+    else H5E_BEGIN_TRY {
+        ret = H5Oget_info_by_name(loc, name, &info, H5P_DEFAULT);
+    } H5E_END_TRY;
+#endif
+    if (ret < 0) {
+        if (hardLink) throw h5exception("Error in call to H5Oget_info_by_name");
+        return QH5Node::UNKNOWN;
+    }
+    switch (info.type)
+    {
+    case H5O_TYPE_GROUP: return QH5Node::GROUP;
+    case H5O_TYPE_DATASET: return QH5Node::DATASET;
+    case H5O_TYPE_NAMED_DATATYPE: return QH5Node::DATATYPE;
+    default: return QH5Node::UNKNOWN;
+    }
+}
 bool QH5Group::exists(const char *name) const
 {
     return isValid() && H5Lexists (_h(id_),name,H5P_DEFAULT);
@@ -662,31 +1609,13 @@ bool QH5Group::exists(const char *name) const
 bool QH5Group::isDataset(const char *name) const
 {
     if (!exists(name)) return false;
-    // use compatibility function for HDF5 <= 1.10
-#if H5_VERSION_GE(1,12,0)
-    H5O_info1_t info;
-    H5Oget_info_by_name1(_h(id_),name,&info,0);
-#else
-    H5O_info_t info;
-    H5Oget_info_by_name(_h(id_),name,&info,0);
-#endif
-    return info.type == H5O_TYPE_DATASET;
+    return _objectType(_h(id_), name, false) == DATASET;
 }
 bool QH5Group::isGroup(const char *name) const
 {
     if (!exists(name)) return false;
-
-    // use compatibility function for HDF5 <= 1.10
-#if H5_VERSION_GE(1,12,0)
-    H5O_info1_t info;
-    H5Oget_info_by_name1(_h(id_),name,&info,0);
-#else
-    H5O_info_t info;
-    H5Oget_info_by_name(_h(id_),name,&info,0);
-#endif
-
-    return info.type == H5O_TYPE_GROUP;
-};
+    return _objectType(_h(id_), name, false) == GROUP;
+}
 bool QH5Group::isCreationOrderIdx() const
 {
     if (!isValid()) return false;
@@ -699,6 +1628,14 @@ bool QH5Group::isCreationOrderIdx() const
     H5Pclose(gcplid);
     return crt_order_flags == (H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
 }
+quint64 QH5Group::linkCount(const char *name) const
+{
+    if (!isValid()) return 0;
+    H5G_info_t info;
+    if (H5Gget_info_by_name(_h(id_), name, &info, H5P_DEFAULT) < 0)
+        throw h5exception("Error in call to H5Gget_info_by_name");
+    return info.nlinks;
+}
 QH5Group QH5Group::createGroup(const char *name, bool idxCreationOrder) const
 {
     if (exists(name)) {
@@ -707,14 +1644,9 @@ QH5Group QH5Group::createGroup(const char *name, bool idxCreationOrder) const
     }
     hid_t gid;
     if (idxCreationOrder) {
-        hid_t group_creation_plist = H5Pcreate(H5P_GROUP_CREATE);
-        herr_t status = H5Pset_link_creation_order(group_creation_plist,
-                                         H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
-        if (status<0) throw h5exception("Error in call to H5Pset_link_creation_order");
-        gid = H5Gcreate(_h(id_), name,
-                        H5P_DEFAULT, group_creation_plist, H5P_DEFAULT);
+        gid = H5Gcreate(_h(id_), name, H5P_DEFAULT,
+                        _h(QH5Registry::instance().gcplCreationOrder), H5P_DEFAULT);
         if (gid < 0) throw h5exception("Error in call to H5Gcreate");
-        H5Pclose(group_creation_plist);
     }
     else {
         gid = H5Gcreate(_h(id_), name,
@@ -737,102 +1669,299 @@ QH5Group QH5Group::openGroup(const char *name) const
 }
 QH5Dataset QH5Group::createDataset(const char *name,
                          const QH5Dataspace& memspace,
-                         const QH5Datatype& datatype) const
+                         const QH5Datatype& datatype,
+                         const QH5DatasetCreateOptions& options) const
 {
     if (exists(name)) {
         // error
         return QH5Dataset();
     }
+    QH5id dcpl;
+    if (!options.createPlist(memspace, datatype, dcpl)) {
+        // error: chunk rank does not match the dataspace
+        return QH5Dataset();
+    }
     hid_t dsid = H5Dcreate (_h(id_), name,
                             _h(datatype.id()), _h(memspace.id()),
-                            H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+                            H5P_DEFAULT, dcpl.id() ? _h(dcpl) : H5P_DEFAULT, H5P_DEFAULT);
     if (dsid < 0) throw h5exception("Error in call to H5Dcreate");
 
     return QH5Dataset(static_cast<QH5id::h5id>(dsid), false);
 }
-QH5Dataset QH5Group::openDataset(const char *name) const
+QH5Dataset QH5Group::openDataset(const char *name,
+                                 const QH5DatasetAccessOptions& options) const
 {
     if (!isDataset(name)) {
         // error
         return QH5Dataset();
     }
-    hid_t dsid = H5Dopen(_h(id_), name, H5P_DEFAULT);
+    QH5id dapl = options.createPlist();
+    hid_t dsid = H5Dopen(_h(id_), name, dapl.id() ? _h(dapl) : H5P_DEFAULT);
     if (dsid < 0) throw h5exception("Error in call to H5Dopen");
 
     return QH5Dataset(static_cast<QH5id::h5id>(dsid), false);
 }
+namespace {
+
+struct IterateData
+{
+    const std::function<bool(const QH5GroupEntry&)>* f;
+    QH5GroupEntry entry;
+    std::exception_ptr error;
+};
+
+#if H5_VERSION_GE(1,12,0)
+herr_t iterateCallback(hid_t g, const char* name, const H5L_info2_t* info, void* op)
+#else
+herr_t iterateCallback(hid_t g, const char* name, const H5L_info_t* info, void* op)
+#endif
+{
+    IterateData* d = static_cast<IterateData*>(op);
+    // exceptions must not propagate through the HDF5 library
+    try {
+        d->entry.name = QByteArray(name);
+        d->entry.type = _objectType(g, name, info->type == H5L_TYPE_HARD);
+        return (*d->f)(d->entry) ? 0 : 1;
+    }
+    catch (...) {
+        d->error = std::current_exception();
+        return -1;
+    }
+}
+
+} // namespace
+
+bool QH5Group::iterate(const std::function<bool(const QH5GroupEntry&)>& f,
+                       bool idxCreationOrder, quint64* position) const
+{
+    if (isNull()) return false;
+
+    H5_index_t idx = (idxCreationOrder && isCreationOrderIdx()) ?
+                H5_INDEX_CRT_ORDER : H5_INDEX_NAME;
+    IterateData d;
+    d.f = &f;
+    // H5Literate sets n to the index following the link where it stopped
+    hsize_t n = position ? *position : 0;
+    // H5Literate fails if it starts past the last link
+    if (n && n >= linkCount()) return true;
+#if H5_VERSION_GE(1,12,0)
+    herr_t ret = H5Literate2(_h(id_), idx, H5_ITER_INC, &n, iterateCallback, &d);
+#else
+    herr_t ret = H5Literate(_h(id_), idx, H5_ITER_INC, &n, iterateCallback, &d);
+#endif
+    if (position) *position = n;
+    if (d.error) std::rethrow_exception(d.error);
+    if (ret < 0) throw h5exception("Error in call to H5Literate");
+    return ret == 0;
+}
+QVector<QH5GroupEntry> QH5Group::entries(bool idxCreationOrder) const
+{
+    QVector<QH5GroupEntry> v;
+    iterate([&v](const QH5GroupEntry& e) { v.push_back(e); return true; },
+            idxCreationOrder);
+    return v;
+}
+namespace {
+
+#if H5_VERSION_GE(1,12,0)
+typedef H5O_info2_t ObjectInfo;
+typedef H5L_info2_t LinkInfo;
+#else
+typedef H5O_info_t ObjectInfo;
+typedef H5L_info_t LinkInfo;
+#endif
+
+struct VisitData
+{
+    const std::function<bool(const QH5VisitEntry&)>* f;
+    const QH5VisitFilter* filter;
+    QByteArray prefix; // filter.prefix without leading '/'
+    QByteArray base; // path of the traversal start, relative to the visited group
+    void (*details)(hid_t loc, const char* name, QH5VisitEntry& e);
+    QH5VisitEntry entry;
+    std::exception_ptr error;
+};
+
+// filter and report object name in g
+herr_t visitObject(VisitData* d, hid_t g, const char* name, const ObjectInfo* info)
+{
+    const QH5VisitFilter& filter = *d->filter;
+    QH5VisitEntry& e = d->entry;
+    try {
+        switch (info->type)
+        {
+        case H5O_TYPE_GROUP: e.type = QH5Node::GROUP; break;
+        case H5O_TYPE_DATASET: e.type = QH5Node::DATASET; break;
+        case H5O_TYPE_NAMED_DATATYPE: e.type = QH5Node::DATATYPE; break;
+        default: e.type = QH5Node::UNKNOWN;
+        }
+        if (!(filter.types & QH5VisitFilter::typeBit(e.type))) return 0;
+
+        e.path = d->base;
+        e.path.append(name);
+        if (!e.path.startsWith(d->prefix)) return 0;
+
+        e.depth = e.path.count('/') + 1;
+        if (filter.maxDepth >= 0 && e.depth > filter.maxDepth) return 0;
+
+#if H5_VERSION_GE(1,12,0)
+        // the native VOL connector stores the object address in the token
+        haddr_t addr = 0;
+        memcpy(&addr, &info->token, sizeof(addr));
+        e.address = addr;
+#else
+        e.address = info->addr;
+#endif
+        e.ctime = info->ctime;
+
+        e.shape.clear();
+        e.dtypeClass = QH5Datatype::UNSUPPORTED;
+        if (filter.details && e.type == QH5Node::DATASET) d->details(g, name, e);
+
+        return (*d->f)(e) ? 0 : 1;
+    }
+    catch (...) {
+        d->error = std::current_exception();
+        return -1;
+    }
+}
+
+herr_t visitCallback(hid_t g, const char* name, const ObjectInfo* info, void* op)
+{
+    // skip the start object
+    if (name[0] == '.' && name[1] == 0) return 0;
+    return visitObject(static_cast<VisitData*>(op), g, name, info);
+}
+
+// members of the start group only, when maxDepth excludes their members
+herr_t visitLinkCallback(hid_t g, const char* name, const LinkInfo* link, void* op)
+{
+    // as H5Ovisit, follow only hard links
+    if (link->type != H5L_TYPE_HARD) return 0;
+
+    ObjectInfo info;
+#if H5_VERSION_GE(1,12,0)
+    herr_t ret = H5Oget_info_by_name3(g, name, &info, H5O_INFO_BASIC | H5O_INFO_TIME, H5P_DEFAULT);
+#elif H5_VERSION_GE(1,10,3)
+    herr_t ret = H5Oget_info_by_name2(g, name, &info, H5O_INFO_BASIC | H5O_INFO_TIME, H5P_DEFAULT);
+#else
+    herr_t ret = H5Oget_info_by_name(g, name, &info, H5P_DEFAULT);
+#endif
+    if (ret < 0) return -1;
+    return visitObject(static_cast<VisitData*>(op), g, name, &info);
+}
+
+} // namespace
+
+bool QH5Group::visit(const std::function<bool(const QH5VisitEntry&)>& f,
+                     const QH5VisitFilter& filter) const
+{
+    if (isNull()) return false;
+
+    VisitData d;
+    d.f = &f;
+    d.filter = &filter;
+    d.details = [](hid_t loc, const char* name, QH5VisitEntry& e) {
+        hid_t dsid = H5Dopen(loc, name, H5P_DEFAULT);
+        if (dsid < 0) throw h5exception("Error in call to H5Dopen");
+        QH5Dataset ds(static_cast<QH5id::h5id>(dsid), false);
+        e.shape = ds.dataspace().dimensions();
+        e.dtypeClass = ds.datatype().getClass();
+    };
+
+    // reported paths are relative, as in QH5File::group()
+    int i = 0;
+    while (i < filter.prefix.size() && filter.prefix[i] == '/') ++i;
+    d.prefix = filter.prefix.mid(i);
+
+    // start from the deepest group named in the prefix
+    int k = d.prefix.lastIndexOf('/');
+    if (k > 0) {
+        d.base = d.prefix.left(k + 1);
+        if (_objectType(_h(id_), d.prefix.left(k).constData(), false) != GROUP)
+            return true;
+    }
+    const char* start = k > 0 ? d.base.constData() : ".";
+
+    // depth of the members of the start group
+    int depth = d.base.count('/') + 1;
+    if (filter.maxDepth >= 0 && filter.maxDepth < depth) return true;
+
+    herr_t ret;
+    if (filter.maxDepth == depth) {
+        // no need to descend
+        hsize_t idx = 0;
+#if H5_VERSION_GE(1,12,0)
+        ret = H5Literate_by_name2(_h(id_), start, H5_INDEX_NAME, H5_ITER_INC, &idx,
+                                  visitLinkCallback, &d, H5P_DEFAULT);
+#else
+        ret = H5Literate_by_name(_h(id_), start, H5_INDEX_NAME, H5_ITER_INC, &idx,
+                                 visitLinkCallback, &d, H5P_DEFAULT);
+#endif
+    } else {
+#if H5_VERSION_GE(1,12,0)
+        ret = H5Ovisit_by_name3(_h(id_), start, H5_INDEX_NAME, H5_ITER_INC,
+                                visitCallback, &d, H5O_INFO_BASIC | H5O_INFO_TIME, H5P_DEFAULT);
+#elif H5_VERSION_GE(1,10,3)
+        ret = H5Ovisit_by_name2(_h(id_), start, H5_INDEX_NAME, H5_ITER_INC,
+                                visitCallback, &d, H5O_INFO_BASIC | H5O_INFO_TIME, H5P_DEFAULT);
+#else
+        ret = H5Ovisit_by_name(_h(id_), start, H5_INDEX_NAME, H5_ITER_INC,
+                               visitCallback, &d, H5P_DEFAULT);
+#endif
+    }
+    if (d.error) std::rethrow_exception(d.error);
+    if (ret < 0) throw h5exception("Error in call to H5Ovisit");
+    return ret == 0;
+}
+QVector<QH5VisitEntry> QH5Group::objects(const QH5VisitFilter& filter) const
+{
+    QVector<QH5VisitEntry> v;
+    visit([&v](const QH5VisitEntry& e) { v.push_back(e); return true; }, filter);
+    return v;
+}
 QVector<QH5Group> QH5Group::subGroups(bool idxCreationOrder) const
 {
     QVector<QH5Group> groups;
-    bool crtord = idxCreationOrder ? isCreationOrderIdx() : false;
-    hsize_t n;
-    H5Gget_num_objs(_h(id_),&n);
-    for(hsize_t i=0; i<n; ++i)
-    {
-        QByteArray name = objname_by_idx(i,crtord);
-        if (isGroup(name))
-            groups.push_back(openGroup(name));
-    }
+    iterate([this, &groups](const QH5GroupEntry& e) {
+        if (e.type == GROUP) {
+            hid_t gid = H5Gopen(_h(id_), e.name.constData(), H5P_DEFAULT);
+            if (gid < 0) throw h5exception("Error in call to H5Gopen");
+            groups.push_back(QH5Group(static_cast<QH5id::h5id>(gid), false));
+        }
+        return true;
+    }, idxCreationOrder);
     return groups;
 }
 QVector<QH5Dataset> QH5Group::datasets() const
 {
     QVector<QH5Dataset> ds;
-    hsize_t n;
-    H5Gget_num_objs(_h(id_),&n);
-    for(hsize_t i=0; i<n; ++i)
-    {
-        QByteArray name = objname_by_idx(i,false);
-        if (isDataset(name))
-            ds.push_back(openDataset(name));
-    }
+    iterate([this, &ds](const QH5GroupEntry& e) {
+        if (e.type == DATASET) {
+            hid_t dsid = H5Dopen(_h(id_), e.name.constData(), H5P_DEFAULT);
+            if (dsid < 0) throw h5exception("Error in call to H5Dopen");
+            ds.push_back(QH5Dataset(static_cast<QH5id::h5id>(dsid), false));
+        }
+        return true;
+    });
     return ds;
 }
 QByteArrayList QH5Group::groupNames(bool idxCreationOrder) const
 {
     QByteArrayList names;
-    bool crtord = idxCreationOrder ? isCreationOrderIdx() : false;
-    hsize_t n;
-    H5Gget_num_objs(_h(id_),&n);
-    for(hsize_t i=0; i<n; ++i)
-    {
-        QByteArray name = objname_by_idx(i,crtord);
-        if (isGroup(name))
-            names.push_back(name);
-    }
+    iterate([&names](const QH5GroupEntry& e) {
+        if (e.type == GROUP) names.push_back(e.name);
+        return true;
+    }, idxCreationOrder);
     return names;
 }
-
 QByteArrayList QH5Group::datasetNames() const
 {
     QByteArrayList names;
-    hsize_t n;
-    H5Gget_num_objs(_h(id_),&n);
-    for(hsize_t i=0; i<n; ++i)
-    {
-        QByteArray name = objname_by_idx(i,false);
-        if (isDataset(name)) names.push_back(name);
-    }
+    iterate([&names](const QH5GroupEntry& e) {
+        if (e.type == DATASET) names.push_back(e.name);
+        return true;
+    });
     return names;
 }
 
-QByteArray QH5Group::objname_by_idx(int i, bool idxCreationOrder) const
-{
-    QByteArray name;
-//    ssize_t sz = H5Gget_objname_by_idx(_h(id_),i,NULL,0);
-//    if (sz) {
-//        name.resize(sz);
-//        H5Gget_objname_by_idx(_h(id_),i,name.data(),sz+1);
-//    }
-    H5_index_t idx = idxCreationOrder ? H5_INDEX_CRT_ORDER : H5_INDEX_NAME;
-    ssize_t sz = H5Lget_name_by_idx(_h(id_), ".",
-                                    idx, H5_ITER_INC,i, NULL, 0, 0);
-    if (sz) {
-        name.resize(sz);
-        H5Lget_name_by_idx(_h(id_), ".",idx,H5_ITER_INC,
-                           i, name.data(), sz+1, 0);
-    }
-
-    return name;
-}
-
@@ -5,8 +5,19 @@
 #include <QVector>
 #include <QMetaType>
 #include <QFile>
+#include <QSharedPointer>
+
+#include <QVarLengthArray>
 
 #include <exception>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <array>
+#include <climits>
+#include <complex>
+#include <type_traits>
 
 #define HDF_EXPORT
 
@@ -14,6 +25,9 @@ class QH5Datatype;
 class QH5Group;
 class QH5Dataset;
 class QH5File;
+class QThreadPool;
+
+template<typename T, typename Enable = void> struct QH5TypeMap;
 
 /**
  * @brief A wrapper for HDF5 object identifiers 
@@ -48,6 +62,15 @@ public:
      */
     QH5id(const QH5id& o);
 
+    /**
+     * @brief Move constructor
+     * 
+     * The id is transferred from o without calling HDF5. o becomes null.
+     * 
+     * @param o Another QH5id object
+     */
+    QH5id(QH5id&& o) : id_(o.id_), kind_(o.kind_) { o.id_ = 0; }
+
     /**
      * @brief Destroy the QH5id object
      * 
@@ -68,6 +91,17 @@ public:
      */
     QH5id& operator=(const QH5id& rhs);
 
+    /**
+     * @brief Move assignement operator.
+     * 
+     * The current HDF5 id of this object is released and the id 
+     * of rhs is transferred to this object. rhs becomes null.
+     * 
+     * @param rhs 
+     * @return QH5id& 
+     */
+    QH5id& operator=(QH5id&& rhs);
+
     /**
      * @brief Check if this id is valid
      * 
@@ -78,6 +112,17 @@ public:
      */
     bool isValid() const;
 
+    /**
+     * @brief Check if this object holds an id
+     * 
+     * Does not call HDF5. An object that holds an id keeps a reference to it, 
+     * so it remains valid unless it is closed outside QtHDF5.
+     * 
+     * @return true If no id is held, e.g., default constructed, closed or moved-from objects 
+     * @return false Otherwise
+     */
+    bool isNull() const { return id_ <= 0; }
+
     /**
      * @brief Returns the stored id
      */
@@ -95,9 +140,9 @@ public:
     /**
      * @brief Close this id
      * 
-     * If isValid() returns true, the type of identifier is queried
-     * with H5Iget_type and then the appropriate H5Xclose function
-     * is called.
+     * The appropriate H5Xclose function is called for the type of
+     * identifier. The type is known for typed wrappers, e.g., QH5Group,
+     * otherwise it is queried with H5Iget_type.
      * 
      * @return true Identifier closed succesfully
      * @return false Invalid id or error while closing id
@@ -138,7 +183,22 @@ public:
     bool isDataset() const;
 
 protected:
+    /*
+     * Kind of HDF5 object, so that close() does not need H5Iget_type
+     */
+    enum Kind {
+        KIND_UNKNOWN,
+        KIND_FILE,
+        KIND_GROUP,
+        KIND_DATATYPE,
+        KIND_DATASPACE,
+        KIND_DATASET
+    };
+
     h5id id_;
+    Kind kind_;
+
+    QH5id(h5id id, bool incref, Kind kind);
 
     bool ref() const;
     bool deref() const;
@@ -148,7 +208,7 @@ protected:
 /**
  * @brief Return true if the 2 ids are equal.
  * 
- * The 2 ids must be valid and wrap the same HDF5 id.
+ * The 2 ids must not be null and wrap the same HDF5 id.
  * 
  * @param lhs 
  * @param rhs 
@@ -157,8 +217,7 @@ protected:
 HDF_EXPORT
 inline bool operator==(const QH5id &lhs, const QH5id &rhs)
 {
-  if ((!rhs.isValid()) || (!lhs.isValid())) return false;
-  return lhs.id() == rhs.id();
+  return lhs.id() == rhs.id() && !lhs.isNull();
 }
 HDF_EXPORT
 inline bool operator!=(const QH5id &lhs, const QH5id &rhs)
@@ -173,7 +232,7 @@ inline bool operator!=(const QH5id &lhs, const QH5id &rhs)
 class HDF_EXPORT QH5Dataspace : public QH5id
 {
     friend class QH5Dataset;
-    QH5Dataspace(h5id id, bool incref) : QH5id(id,incref) {}
+    QH5Dataspace(h5id id, bool incref) : QH5id(id,incref,KIND_DATASPACE) {}
 public:
 
     /**
@@ -190,6 +249,11 @@ public:
      */
     QH5Dataspace(const QVector<quint64>& dims = QVector<quint64>());
 
+    /**
+     * @brief Value of a maximum dimension that may grow without limit (H5S_UNLIMITED)
+     */
+    static const quint64 UNLIMITED = ~quint64(0);
+
     /**
      * @brief Return the dimensions of the HDF5 dataspace
      *
@@ -199,6 +263,21 @@ public:
      */
     QVector<quint64> dimensions() const;
 
+    /**
+     * @brief Return the maximum dimensions of the HDF5 dataspace
+     *
+     * Calls H5Sget_simple_extent_dims. Unlimited dimensions are
+     * returned as QH5Dataspace::UNLIMITED. 
+     * 
+     * For scalar and empty dataspaces the result is the same as dimensions().
+     */
+    QVector<quint64> maxDimensions() const;
+
+    /**
+     * @brief Returns true if any of the dimensions can be extended
+     */
+    bool isExtendible() const;
+
     /**
      * @brief Returns the number of elements
      *
@@ -212,6 +291,136 @@ public:
      * @brief Create a scalar dataspace
      */
     static QH5Dataspace scalar();
+
+    /**
+     * @brief Create an extendible dataspace 
+     * 
+     * A simple dataspace (H5S_SIMPLE) is created with current dimensions dims
+     * and maximum dimensions maxdims. Dimensions that can grow without limit are 
+     * specified with QH5Dataspace::UNLIMITED. If maxdims is empty all dimensions
+     * are unlimited.
+     * 
+     * dims may contain zeros, e.g., extendible({0}) creates an 
+     * initially empty 1D dataspace that can be extended.
+     * 
+     * Datasets with extendible dataspaces always have a chunked layout.
+     * 
+     * @param dims A vector of current dimensions
+     * @param maxdims A vector of maximum dimensions, same size as dims
+     * @return QH5Dataspace The new dataspace, invalid if the sizes of dims & maxdims differ 
+     */
+    static QH5Dataspace extendible(const QVector<quint64>& dims,
+                                   const QVector<quint64>& maxdims = QVector<quint64>());
+
+    /**
+     * @brief Enum corresponding to H5S_seloper_t
+     * 
+     * Determines how a new hyperslab is combined with the current selection.
+     */
+    enum SelectionOperator {
+        SELECT_SET,     //!< replace the current selection (H5S_SELECT_SET)
+        SELECT_OR,      //!< union with the current selection (H5S_SELECT_OR)
+        SELECT_AND,     //!< intersection with the current selection (H5S_SELECT_AND)
+        SELECT_XOR,     //!< symmetric difference with the current selection (H5S_SELECT_XOR)
+        SELECT_NOTB,    //!< current selection minus the new hyperslab (H5S_SELECT_NOTB)
+        SELECT_NOTA     //!< new hyperslab minus the current selection (H5S_SELECT_NOTA)
+    };
+
+    /**
+     * @brief Return the number of dimensions of the dataspace
+     * 
+     * Calls H5Sget_simple_extent_ndims. Scalar dataspaces have rank 0.
+     */
+    int rank() const;
+
+    /**
+     * @brief Select the entire extent of the dataspace
+     * 
+     * Calls H5Sselect_all
+     * 
+     * @return true If succesfull
+     * @return false If this object is invalid
+     */
+    bool selectAll() const;
+
+    /**
+     * @brief Clear the selection
+     * 
+     * Calls H5Sselect_none
+     * 
+     * @return true If succesfull
+     * @return false If this object is invalid
+     */
+    bool selectNone() const;
+
+    /**
+     * @brief Select a hyperslab region
+     * 
+     * Calls H5Sselect_hyperslab. The hyperslab starts at offset and consists of count blocks
+     * separated by stride elements. Each block has the size given by block.
+     * 
+     * If stride or block are empty a value of 1 is assumed in all dimensions, so that
+     * offset & count define a simple rectangular region.
+     * 
+     * Unions and other combinations of hyperslabs can be formed by calling the function
+     * repeatedly with an appropriate op.
+     * 
+     * Note that copies of a QH5Dataspace share the same selection. 
+     * 
+     * \code
+     * // select the last 1000 samples of a 1D dataset
+     * QH5Dataspace sel = ds.dataspace();
+     * quint64 n = sel.dimensions()[0];
+     * sel.selectHyperslab({n-1000},{1000});
+     * QVector<double> v;
+     * ds.read(v, sel);
+     * \endcode
+     * 
+     * @param offset Starting position of the hyperslab 
+     * @param count Number of blocks in each dimension
+     * @param stride Distance between blocks
+     * @param block Size of each block 
+     * @param op How to combine with the current selection
+     * @return true If succesfull
+     * @return false If this object is invalid or the vector sizes do not match rank()
+     */
+    bool selectHyperslab(const QVector<quint64>& offset,
+                         const QVector<quint64>& count,
+                         const QVector<quint64>& stride = QVector<quint64>(),
+                         const QVector<quint64>& block = QVector<quint64>(),
+                         SelectionOperator op = SELECT_SET) const;
+
+    /**
+     * @brief Select individual elements
+     * 
+     * Calls H5Sselect_elements, replacing the current selection. coords holds
+     * rank() coordinates for each element, e.g., {x0, y0, x1, y1, ...} for a 2D
+     * dataspace. Elements are read or written in the order they are listed.
+     * 
+     * @param coords Coordinates of the elements
+     * @return true If succesfull
+     * @return false If this object is invalid or the size of coords is not a multiple of rank()
+     */
+    bool selectElements(const QVector<quint64>& coords) const;
+
+    /**
+     * @brief Returns the number of selected elements
+     * 
+     * Calls H5Sget_select_npoints
+     */
+    quint64 selectionSize() const;
+
+    /**
+     * @brief Get the bounding box of the current selection
+     * 
+     * Calls H5Sget_select_bounds
+     * 
+     * @param start Coordinates of the first corner of the bounding box
+     * @param end Coordinates of the opposite corner (inclusive)
+     * @return true If succesfull
+     * @return false If this object is invalid or there is no selection
+     */
+    bool selectionBounds(QVector<quint64>& start, QVector<quint64>& end) const;
 };
 
 /**
@@ -224,7 +433,7 @@ class HDF_EXPORT QH5Datatype : public QH5id
     friend class QH5Group;
     friend class QH5Dataset;
 
-    QH5Datatype(h5id id, bool incref) : QH5id(id,incref) {}
+    QH5Datatype(h5id id, bool incref) : QH5id(id,incref,KIND_DATATYPE) {}
 
     /*
      * Create from a Qt metatype id
@@ -241,7 +450,8 @@ public:
      * from HDF5 to other datatypes.
      * 
      * QtHDF5 provides specializations of this template for
-     * QVector<T>, QString, QStringList.
+     * QVector<T>, QString, QStringList, std::vector<T>, std::array<T,N>,
+     * QVarLengthArray<T>, QByteArray and QH5AlignedBuffer<T>.
      * 
      * Further specializations can be defined if needed. 
      * 
@@ -249,6 +459,17 @@ public:
      */
     template<typename T>
     struct traits {
+        /**
+         * @brief The type of the stored values
+         * 
+         * For container classes this is the element type. If QH5TypeMap 
+         * is specialized for value_type the HDF5 datatype is obtained from 
+         * it, otherwise from metaTypeId().
+         * 
+         * Specializations that do not declare value_type, e.g., written for
+         * earlier versions, always use metaTypeId().
+         */
+        typedef T value_type;
         /**
          * @brief Returns the Qt metatype id of the base type.
          * 
@@ -296,7 +517,30 @@ public:
         UNSUPPORTED,    //!< invalid or unsupported type
         INTEGER,        //!< integer type (H5T_INTEGER)
         FLOAT,          //!< float type (H5T_FLOAT)
-        STRING          //!< string type (H5T_STRING)
+        STRING,         //!< string type (H5T_STRING)
+        COMPOUND,       //!< compound type (H5T_COMPOUND)
+        ARRAY           //!< array type (H5T_ARRAY)
+    };
+
+    /**
+     * @brief Native HDF5 datatypes available through native()
+     */
+    enum NativeType {
+        NATIVE_INT8,            //!< H5T_NATIVE_INT8
+        NATIVE_UINT8,           //!< H5T_NATIVE_UINT8
+        NATIVE_INT16,           //!< H5T_NATIVE_INT16
+        NATIVE_UINT16,          //!< H5T_NATIVE_UINT16
+        NATIVE_INT32,           //!< H5T_NATIVE_INT32
+        NATIVE_UINT32,          //!< H5T_NATIVE_UINT32
+        NATIVE_INT64,           //!< H5T_NATIVE_INT64
+        NATIVE_UINT64,          //!< H5T_NATIVE_UINT64
+        NATIVE_FLOAT,           //!< H5T_NATIVE_FLOAT
+        NATIVE_DOUBLE,          //!< H5T_NATIVE_DOUBLE
+        NATIVE_LDOUBLE,         //!< H5T_NATIVE_LDOUBLE
+        NATIVE_HBOOL,           //!< H5T_NATIVE_HBOOL
+        NATIVE_COMPLEX_FLOAT,   //!< compound {r, i} of H5T_NATIVE_FLOAT, layout of std::complex<float>
+        NATIVE_COMPLEX_DOUBLE,  //!< compound {r, i} of H5T_NATIVE_DOUBLE, layout of std::complex<double>
+        NATIVE_TYPE_COUNT
     };
 
     /**
@@ -317,13 +561,70 @@ public:
 
     /**
      * @brief Construct a QH5Datatype object corresponding to v 's type
+     * 
+     * If QH5TypeMap is specialized for traits<T>::value_type, the datatype 
+     * is selected at compile time and a shared handle is returned.
+     * 
+     * Otherwise the datatype is obtained at runtime from the Qt metatype id 
+     * with fromMetaTypeId().
      */
     template<typename T>
     static QH5Datatype fromValue(const T& v)
     {
-        return fromMetaTypeId(traits<T>::metaTypeId(v));
+        return fromValue_(v, std::integral_constant<bool,
+                          QH5TypeMap<typename valueType_<T>::type>::defined>());
     }
 
+    /**
+     * @brief Return a native HDF5 datatype
+     * 
+     * The datatypes are created once per process and shared, so that
+     * no H5Tcopy takes place. They are locked: functions that modify
+     * them fail with an h5exception. Use copy() to obtain a modifiable type.
+     */
+    static QH5Datatype native(NativeType t);
+
+    /**
+     * @brief Return a modifiable copy of this datatype
+     * 
+     * Calls H5Tcopy. Datatypes returned by fromValue() and native()
+     * are shared and locked, they must be copied before changing
+     * their properties, e.g., with setStringTraits().
+     */
+    QH5Datatype copy() const;
+
+    /**
+     * @brief Create a compound datatype
+     * 
+     * Calls H5Tcreate. Members are added with insertMember().
+     * 
+     * @param size Size of the compound type in bytes, e.g., sizeof of a struct
+     */
+    static QH5Datatype compound(size_t size);
+
+    /**
+     * @brief Add a member to a compound datatype
+     * 
+     * Calls H5Tinsert.
+     * 
+     * @param name Member name
+     * @param offset Byte offset of the member, e.g., offsetof(S, member)
+     * @param type Member datatype
+     * @return true If succesfull
+     * @return false If this is not a compound datatype
+     */
+    bool insertMember(const char* name, size_t offset, const QH5Datatype& type) const;
+
+    /**
+     * @brief Create an array datatype
+     * 
+     * Calls H5Tarray_create2.
+     * 
+     * @param base The element datatype
+     * @param dims The array dimensions
+     */
+    static QH5Datatype array(const QH5Datatype& base, const QVector<quint64>& dims);
+
     /**
      * @brief Get the Class of this datatype
      * 
@@ -343,6 +644,13 @@ public:
      */
     int metaTypeId() const;
 
+    /**
+     * @brief Get the native memory datatype corresponding to this datatype
+     * 
+     * Calls H5Tget_native_type
+     */
+    QH5Datatype nativeType() const;
+
     /**
      * @brief Get the size of this datatype
      * 
@@ -386,11 +694,128 @@ public:
      */
     static QH5Datatype fixedString(int size);
 
+private:
+    // traits<T>::value_type, or void if the specialization does not declare it
+    template<typename U>
+    struct void_ { typedef void type; };
+    template<typename T, typename Enable = void>
+    struct valueType_ { typedef void type; };
+    template<typename T>
+    struct valueType_<T, typename void_<typename traits<T>::value_type>::type> {
+        typedef typename traits<T>::value_type type;
+    };
+
+    template<typename T>
+    static QH5Datatype fromValue_(const T&, std::true_type)
+    {
+        return QH5TypeMap<typename valueType_<T>::type>::datatype();
+    }
+    template<typename T>
+    static QH5Datatype fromValue_(const T& v, std::false_type)
+    {
+        return fromMetaTypeId(traits<T>::metaTypeId(v));
+    }
+};
+
+/**
+ * @brief Compile-time mapping of C++ types to HDF5 datatypes
+ * 
+ * Specializations define defined = 1 and a static function datatype()
+ * returning the HDF5 datatype of T. 
+ * 
+ * QtHDF5 provides specializations for the arithmetic types, 
+ * std::complex<float> and std::complex<double> and
+ * fixed-size arrays T[N] of mapped types.
+ * 
+ * The mapping can be extended to user-defined POD types, e.g.
+ * 
+ * \code
+ * struct Point { double x, y; };
+ * 
+ * template<> struct QH5TypeMap<Point> {
+ *     enum { defined = 1 };
+ *     static QH5Datatype datatype()
+ *     {
+ *         static const QH5Datatype t = make();
+ *         return t;
+ *     }
+ *     static QH5Datatype make()
+ *     {
+ *         QH5Datatype t = QH5Datatype::compound(sizeof(Point));
+ *         t.insertMember("x", offsetof(Point, x), QH5TypeMap<double>::datatype());
+ *         t.insertMember("y", offsetof(Point, y), QH5TypeMap<double>::datatype());
+ *         return t;
+ *     }
+ * };
+ * \endcode
+ * 
+ * Types that are not mapped are handled through the Qt metatype system.
+ * 
+ * @tparam T A C++ type
+ */
+template<typename T, typename Enable>
+struct QH5TypeMap {
+    enum { defined = 0 };
+};
+
+// integer types, selected by size and sign
+template<typename T>
+struct QH5TypeMap<T, typename std::enable_if<std::is_integral<T>::value &&
+        !std::is_same<T, bool>::value>::type> {
+    enum { defined = 1 };
+    static QH5Datatype datatype()
+    {
+        return QH5Datatype::native(QH5Datatype::NativeType(
+            2*(sizeof(T)==1 ? 0 : sizeof(T)==2 ? 1 : sizeof(T)==4 ? 2 : 3) +
+            (std::is_signed<T>::value ? 0 : 1)));
+    }
+};
+template<>
+struct QH5TypeMap<bool> {
+    enum { defined = 1 };
+    static QH5Datatype datatype() { return QH5Datatype::native(QH5Datatype::NATIVE_HBOOL); }
+};
+template<>
+struct QH5TypeMap<float> {
+    enum { defined = 1 };
+    static QH5Datatype datatype() { return QH5Datatype::native(QH5Datatype::NATIVE_FLOAT); }
+};
+template<>
+struct QH5TypeMap<double> {
+    enum { defined = 1 };
+    static QH5Datatype datatype() { return QH5Datatype::native(QH5Datatype::NATIVE_DOUBLE); }
+};
+template<>
+struct QH5TypeMap<long double> {
+    enum { defined = 1 };
+    static QH5Datatype datatype() { return QH5Datatype::native(QH5Datatype::NATIVE_LDOUBLE); }
+};
+template<>
+struct QH5TypeMap<std::complex<float>> {
+    enum { defined = 1 };
+    static QH5Datatype datatype() { return QH5Datatype::native(QH5Datatype::NATIVE_COMPLEX_FLOAT); }
+};
+template<>
+struct QH5TypeMap<std::complex<double>> {
+    enum { defined = 1 };
+    static QH5Datatype datatype() { return QH5Datatype::native(QH5Datatype::NATIVE_COMPLEX_DOUBLE); }
+};
+// fixed-size arrays, e.g. double[3]
+template<typename T, size_t N>
+struct QH5TypeMap<T[N], typename std::enable_if<QH5TypeMap<T>::defined>::type> {
+    enum { defined = 1 };
+    static QH5Datatype datatype()
+    {
+        static const QH5Datatype t = QH5Datatype::array(QH5TypeMap<T>::datatype(),
+                                                        QVector<quint64>(1,N));
+        return t;
+    }
 };
 
 // specialization for vectors
 template<typename T>
 struct QH5Datatype::traits<QVector<T>> {
+    typedef T value_type;
     static int metaTypeId(const QVector<T> &) { return qMetaTypeId<T>(); }
     static QH5Dataspace dataspace(const QVector<T> &value)
     { return QVector<quint64>(1,value.size()); }
@@ -402,6 +827,7 @@ struct QH5Datatype::traits<QVector<T>> {
 // specialization for QString
 template<>
 struct QH5Datatype::traits<QString> {
+    typedef QString value_type;
     static int metaTypeId(const QString &) { return qMetaTypeId<QString>(); }
     static QH5Dataspace dataspace(const QString &)
     { return QVector<quint64>({1}); }
@@ -409,12 +835,141 @@ struct QH5Datatype::traits<QString> {
 // specialization for QStringList
 template<>
 struct QH5Datatype::traits<QStringList> {
+    typedef QString value_type;
     static int metaTypeId(const QStringList &)
     { return qMetaTypeId<QString>(); }
     static QH5Dataspace dataspace(const QStringList & value)
     { return QVector<quint64>(1,value.size()); }
 };
 
+// specialization for std::vector
+template<typename T, typename A>
+struct QH5Datatype::traits<std::vector<T, A>> {
+    typedef T value_type;
+    static int metaTypeId(const std::vector<T, A> &) { return qMetaTypeId<T>(); }
+    static QH5Dataspace dataspace(const std::vector<T, A> &value)
+    { return QVector<quint64>(1,value.size()); }
+    static void resize(std::vector<T, A> & v, int n) { v.resize(n); }
+    static void *ptr(std::vector<T, A> &data) { return reinterpret_cast<void *>(data.data()); }
+    static const void *cptr(const std::vector<T, A> &data)
+    { return reinterpret_cast<const void *>(data.data()); }
+};
+// specialization for std::array, cannot be resized
+template<typename T, size_t N>
+struct QH5Datatype::traits<std::array<T, N>> {
+    typedef T value_type;
+    static int metaTypeId(const std::array<T, N> &) { return qMetaTypeId<T>(); }
+    static QH5Dataspace dataspace(const std::array<T, N> &)
+    { return QVector<quint64>(1,N); }
+    static void resize(std::array<T, N> &, int) {}
+    static void *ptr(std::array<T, N> &data) { return reinterpret_cast<void *>(data.data()); }
+    static const void *cptr(const std::array<T, N> &data)
+    { return reinterpret_cast<const void *>(data.data()); }
+};
+// specialization for QVarLengthArray
+template<typename T, int P>
+struct QH5Datatype::traits<QVarLengthArray<T, P>> {
+    typedef T value_type;
+    static int metaTypeId(const QVarLengthArray<T, P> &) { return qMetaTypeId<T>(); }
+    static QH5Dataspace dataspace(const QVarLengthArray<T, P> &value)
+    { return QVector<quint64>(1,value.size()); }
+    static void resize(QVarLengthArray<T, P> & v, int n) { v.resize(n); }
+    static void *ptr(QVarLengthArray<T, P> &data) { return reinterpret_cast<void *>(data.data()); }
+    static const void *cptr(const QVarLengthArray<T, P> &data)
+    { return reinterpret_cast<const void *>(data.constData()); }
+};
+// specialization for QByteArray, an array of bytes
+template<>
+struct QH5Datatype::traits<QByteArray> {
+    typedef quint8 value_type;
+    static int metaTypeId(const QByteArray &) { return qMetaTypeId<quint8>(); }
+    static QH5Dataspace dataspace(const QByteArray &value)
+    { return QVector<quint64>(1,value.size()); }
+    static void resize(QByteArray & v, int n) { v.resize(n); }
+    static void *ptr(QByteArray &data) { return reinterpret_cast<void *>(data.data()); }
+    static const void *cptr(const QByteArray &data)
+    { return reinterpret_cast<const void *>(data.constData()); }
+};
+
+/**
+ * @brief An aligned array of trivially copyable elements
+ * 
+ * The elements are not initialized when the buffer is allocated or resized, 
+ * so that data read from HDF5 is written to the memory exactly once.
+ * 
+ * The data are aligned to Align bytes (default 64, a cache line) which is 
+ * also suitable for SIMD processing.
+ * 
+ * \code
+ * QH5AlignedBuffer<float> buff;
+ * ds.read(buff); // buff is resized to the dataset size
+ * \endcode
+ * 
+ * @tparam T Element type
+ * @tparam Align Alignment in bytes
+ */
+template<typename T, size_t Align = 64>
+class QH5AlignedBuffer
+{
+public:
+    QH5AlignedBuffer() : d_(0), n_(0) {}
+    explicit QH5AlignedBuffer(int n) : d_(0), n_(0) { resize(n); }
+    QH5AlignedBuffer(QH5AlignedBuffer&& o) : d_(o.d_), n_(o.n_) { o.d_ = 0; o.n_ = 0; }
+    QH5AlignedBuffer& operator=(QH5AlignedBuffer&& o)
+    {
+        std::swap(d_, o.d_);
+        std::swap(n_, o.n_);
+        return *this;
+    }
+    ~QH5AlignedBuffer() { qFreeAligned(d_); }
+
+    /**
+     * @brief Resize the buffer to n elements
+     * 
+     * The first min(n, size()) elements are preserved, new elements are uninitialized.
+     */
+    void resize(int n)
+    {
+        if (n == n_) return;
+        void* p = qReallocAligned(d_, size_t(n)*sizeof(T), size_t(n_)*sizeof(T), Align);
+        if (n && !p) return;
+        d_ = static_cast<T*>(p);
+        n_ = n;
+    }
+    int size() const { return n_; }
+    bool isEmpty() const { return n_ == 0; }
+
+    T* data() { return d_; }
+    const T* data() const { return d_; }
+    const T* constData() const { return d_; }
+
+    T& operator[](int i) { return d_[i]; }
+    const T& operator[](int i) const { return d_[i]; }
+
+    T* begin() { return d_; }
+    T* end() { return d_ + n_; }
+    const T* begin() const { return d_; }
+    const T* end() const { return d_ + n_; }
+
+private:
+    T* d_;
+    int n_;
+
+    Q_DISABLE_COPY(QH5AlignedBuffer)
+};
+// specialization for QH5AlignedBuffer
+template<typename T, size_t A>
+struct QH5Datatype::traits<QH5AlignedBuffer<T, A>> {
+    typedef T value_type;
+    static int metaTypeId(const QH5AlignedBuffer<T, A> &) { return qMetaTypeId<T>(); }
+    static QH5Dataspace dataspace(const QH5AlignedBuffer<T, A> &value)
+    { return QVector<quint64>(1,value.size()); }
+    static void resize(QH5AlignedBuffer<T, A> & v, int n) { v.resize(n); }
+    static void *ptr(QH5AlignedBuffer<T, A> &data) { return reinterpret_cast<void *>(data.data()); }
+    static const void *cptr(const QH5AlignedBuffer<T, A> &data)
+    { return reinterpret_cast<const void *>(data.constData()); }
+};
+
 /**
  * @brief Represents a node in a HDF5 file
  * 
@@ -429,8 +984,18 @@ class HDF_EXPORT QH5Node : public QH5id
     friend class QH5id;
     friend class QH5Dataset;
     friend class QH5Group;
-    QH5Node(h5id id, bool incref) : QH5id(id,incref) {}
+    QH5Node(h5id id, bool incref, Kind kind = KIND_UNKNOWN) : QH5id(id,incref,kind) {}
 public:
+    /**
+     * @brief Type of a HDF5 object, corresponding to H5O_type_t
+     */
+    enum Type {
+        UNKNOWN,    //!< unknown type or dangling link
+        GROUP,      //!< group (H5O_TYPE_GROUP)
+        DATASET,    //!< dataset (H5O_TYPE_DATASET)
+        DATATYPE    //!< named datatype (H5O_TYPE_NAMED_DATATYPE)
+    };
+
     /**
      * @brief Default constructor
      * 
@@ -517,63 +1082,565 @@ inline bool QH5Node::writeAttribute<QString>(const char* name, const QString& va
 };
 
 /**
- * @brief A wrapper for HDF5 datasets
+ * @brief Configuration of the HDF5 raw data chunk cache
+ * 
+ * Corresponds to the parameters of H5Pset_cache / H5Pset_chunk_cache.
+ * 
+ * HDF5 keeps one chunk cache per open dataset. A chunk cache that is 
+ * too small for the access pattern, e.g., a 2D viewer walking across a row of chunks,
+ * leads to repeated reading and decompression of the same chunks.
+ * 
+ * A default constructed object has all members set to DEFAULT, meaning 
+ * that the file-wide settings (or the library defaults: 521 slots, 1 MiB, w0=0.75) are used.
  * 
  */
-class HDF_EXPORT QH5Dataset : public QH5Node
+struct HDF_EXPORT QH5ChunkCache
 {
-    friend class QH5id;
-    friend class QH5Group;
-    QH5Dataset(h5id id, bool incref) : QH5Node(id,incref) {}
-
-public:
     /**
-     * @brief Default constructor
-     * 
-     * Creates an invalid QH5Dataset object
-     * 
+     * @brief Value of nslots or bytes that selects the default setting
      */
-    QH5Dataset() : QH5Node() {}
+    static const size_t DEFAULT = ~size_t(0);
 
-    QH5Dataset& operator=(const QH5Dataset& o)
-    { *((QH5id*)this) = o; return *this; }
+    size_t nslots;  //!< number of slots in the hash table, ideally a prime ~100x the number of chunks in the cache
+    size_t bytes;   //!< total size of the cache in bytes
+    double w0;      //!< preemption policy, 0..1. 1 = evict fully read/written chunks first. <0 for default.
 
     /**
-     * @brief Return the associated datatype
+     * @brief Construct an object with default settings
      */
-    QH5Datatype datatype() const;
+    QH5ChunkCache() : nslots(DEFAULT), bytes(DEFAULT), w0(-1.) {}
 
     /**
-     * @brief Return the associated dataspace
+     * @brief Construct an object with the given settings
      */
-    QH5Dataspace dataspace() const;
+    QH5ChunkCache(size_t n, size_t nbytes, double preemption = 0.75) :
+        nslots(n), bytes(nbytes), w0(preemption) {}
 
     /**
-     * @brief Write data to this dataset
-     * 
-     * Datatype and dataspace are inferred from data. 
-     * 
-     * @tparam T Type of the data
-     * @param data data to write
-     * @return true if data was written, false otherwise
+     * @brief Returns true if all members have default values
      */
-    template<typename T>
-    bool write(const T& data) const
-    {
-        QH5Datatype datatype = QH5Datatype::fromValue(data);
-        return write_(QH5Datatype::traits<T>::cptr(data),
-                      QH5Datatype::traits<T>::dataspace(data),
-                      datatype);
-    }
+    bool isDefault() const { return nslots==DEFAULT && bytes==DEFAULT && w0 < 0; }
 
     /**
-     * @brief Write data to this dataset
+     * @brief Create a cache configuration that holds nchunks chunks
      * 
-     * @tparam T Type of the data
-     * @param data data to write
-     * @param memspace memory dataspace
-     * @param memtype memory datatype
-     * @return true if data was written, false otherwise
+     * The number of slots is set to the smallest prime larger than 100*nchunks.
+     * 
+     * @param nchunks The number of chunks the cache should hold, e.g., the number of
+     * chunks in a row of a 2D dataset
+     * @param chunkBytes The size of a chunk in bytes
+     * @param preemption The preemption policy w0
+     */
+    static QH5ChunkCache forChunks(size_t nchunks, size_t chunkBytes, double preemption = 0.75);
+};
+
+/**
+ * @brief Options for the creation of HDF5 datasets
+ * 
+ * Collects the settings of a HDF5 dataset creation property list: chunked layout,
+ * compression & other filters, fill value and space allocation time.
+ * 
+ * The options are passed to QH5Group::createDataset() or QH5Group::write()
+ * and take effect only when a new dataset is created.
+ * 
+ * \code
+ * QH5DatasetCreateOptions opt;
+ * opt.setChunk({4096});
+ * opt.setShuffle();
+ * opt.setDeflate(4);
+ * root.write("signal", v, opt);
+ * \endcode
+ * 
+ * Filters are always applied in the following order, independently of the order
+ * the setters are called: n-bit, scale-offset, shuffle, deflate, fletcher32.
+ * 
+ * Filters and extendible dataspaces require a chunked layout. If a chunk shape
+ * has not been set a default is chosen based on the dataset dimensions.
+ * Scalar and empty datasets are always created with the default (contiguous) layout.
+ * 
+ */
+class HDF_EXPORT QH5DatasetCreateOptions
+{
+    friend class QH5Group;
+    friend class QH5Dataset;
+public:
+    /**
+     * @brief Enum corresponding to H5D_alloc_time_t
+     */
+    enum AllocTime {
+        ALLOC_DEFAULT,  //!< library default for the dataset layout (H5D_ALLOC_TIME_DEFAULT)
+        ALLOC_EARLY,    //!< allocate all space when the dataset is created (H5D_ALLOC_TIME_EARLY)
+        ALLOC_INCR,     //!< allocate chunks as data is written (H5D_ALLOC_TIME_INCR)
+        ALLOC_LATE      //!< allocate space when data is first written (H5D_ALLOC_TIME_LATE)
+    };
+
+    /**
+     * @brief Enum corresponding to H5Z_SO_scale_type_t
+     */
+    enum ScaleType {
+        SCALE_FLOAT_DSCALE, //!< floating point, factor is the number of decimal digits kept (H5Z_SO_FLOAT_DSCALE)
+        SCALE_FLOAT_ESCALE, //!< floating point, exponent scaling (H5Z_SO_FLOAT_ESCALE)
+        SCALE_INT           //!< integer, factor is the number of bits kept (H5Z_SO_INT)
+    };
+
+    /**
+     * @brief Default constructor
+     * 
+     * Corresponds to the HDF5 defaults: contiguous layout, no filters.
+     */
+    QH5DatasetCreateOptions() :
+        deflate_(-1), shuffle_(false), fletcher32_(false), nbit_(false),
+        scaleOffset_(false), scaleType_(SCALE_INT), scaleFactor_(0),
+        allocTime_(ALLOC_DEFAULT)
+    {}
+
+    /**
+     * @brief Set the chunk shape
+     * 
+     * Calls H5Pset_chunk. The size of dims must be equal to the rank of the dataset.
+     * 
+     * An empty vector resets to the default layout.
+     */
+    void setChunk(const QVector<quint64>& dims) { chunk_ = dims; }
+    /**
+     * @brief Return the chunk shape or an empty vector if not chunked
+     */
+    const QVector<quint64>& chunk() const { return chunk_; }
+
+    /**
+     * @brief Set the compression level of the deflate (gzip) filter
+     * 
+     * Calls H5Pset_deflate. Valid levels are 0-9. A negative value disables the filter.
+     */
+    void setDeflate(int level) { deflate_ = level > 9 ? 9 : level; }
+    /**
+     * @brief Return the deflate level or -1 if the filter is not used
+     */
+    int deflate() const { return deflate_; }
+
+    /**
+     * @brief Enable the byte shuffle filter (H5Pset_shuffle)
+     */
+    void setShuffle(bool on = true) { shuffle_ = on; }
+    /**
+     * @brief Returns true if the shuffle filter is enabled
+     */
+    bool shuffle() const { return shuffle_; }
+
+    /**
+     * @brief Enable the Fletcher32 checksum filter (H5Pset_fletcher32)
+     */
+    void setFletcher32(bool on = true) { fletcher32_ = on; }
+    /**
+     * @brief Returns true if the Fletcher32 filter is enabled
+     */
+    bool fletcher32() const { return fletcher32_; }
+
+    /**
+     * @brief Enable the n-bit filter (H5Pset_nbit)
+     * 
+     * The filter is useful only for datatypes with precision smaller than their size.
+     */
+    void setNbit(bool on = true) { nbit_ = on; }
+    /**
+     * @brief Returns true if the n-bit filter is enabled
+     */
+    bool nbit() const { return nbit_; }
+
+    /**
+     * @brief Enable the scale-offset filter (H5Pset_scaleoffset)
+     * 
+     * @param type Type of scaling
+     * @param factor Scale factor, see the HDF5 documentation of H5Pset_scaleoffset 
+     */
+    void setScaleOffset(ScaleType type, int factor)
+    { scaleOffset_ = true; scaleType_ = type; scaleFactor_ = factor; }
+    /**
+     * @brief Disable the scale-offset filter
+     */
+    void clearScaleOffset() { scaleOffset_ = false; }
+    /**
+     * @brief Returns true if the scale-offset filter is enabled
+     */
+    bool scaleOffset() const { return scaleOffset_; }
+    /**
+     * @brief Returns the type of scaling of the scale-offset filter
+     */
+    ScaleType scaleOffsetType() const { return scaleType_; }
+    /**
+     * @brief Returns the scale factor of the scale-offset filter
+     */
+    int scaleOffsetFactor() const { return scaleFactor_; }
+
+    /**
+     * @brief Set the fill value for unwritten elements
+     * 
+     * Calls H5Pset_fill_value. The value is converted by HDF5 
+     * to the datatype of the dataset.
+     * 
+     * @tparam T Type of the fill value. Only simple types are supported.
+     */
+    template<typename T>
+    void setFillValue(const T& v)
+    {
+        fillType_ = QH5Datatype::fromValue(v);
+        fillValue_ = QByteArray(
+                    reinterpret_cast<const char*>(QH5Datatype::traits<T>::cptr(v)),
+                    sizeof(T));
+    }
+    /**
+     * @brief Returns true if a fill value has been set
+     */
+    bool hasFillValue() const { return !fillValue_.isEmpty(); }
+
+    /**
+     * @brief Set the time of storage space allocation (H5Pset_alloc_time)
+     */
+    void setAllocTime(AllocTime t) { allocTime_ = t; }
+    /**
+     * @brief Return the time of storage space allocation
+     */
+    AllocTime allocTime() const { return allocTime_; }
+
+    /**
+     * @brief Returns true if any filter is enabled
+     */
+    bool hasFilters() const
+    { return deflate_ >= 0 || shuffle_ || fletcher32_ || nbit_ || scaleOffset_; }
+
+    /**
+     * @brief Returns true if the dataset will have a chunked layout
+     */
+    bool isChunked() const { return !chunk_.isEmpty() || hasFilters(); }
+
+private:
+    QVector<quint64> chunk_;
+    int deflate_;
+    bool shuffle_;
+    bool fletcher32_;
+    bool nbit_;
+    bool scaleOffset_;
+    ScaleType scaleType_;
+    int scaleFactor_;
+    AllocTime allocTime_;
+    QByteArray fillValue_;
+    QH5Datatype fillType_;
+
+    /*
+     * Create a HDF5 dataset creation property list.
+     * plist is left invalid if the defaults are adequate.
+     * Returns false if the options do not fit the dataspace.
+     */
+    bool createPlist(const QH5Dataspace& dataspace, const QH5Datatype& datatype,
+                     QH5id& plist) const;
+    /*
+     * Read back the options from a dataset creation property list
+     */
+    static QH5DatasetCreateOptions fromPlist(const QH5id& plist);
+    /*
+     * Choose a chunk shape for the given dimensions & element size
+     */
+    static QVector<quint64> defaultChunk(const QVector<quint64>& dims,
+                                         const QVector<quint64>& maxdims,
+                                         size_t typeSize);
+};
+
+/**
+ * @brief Location and size of a stored chunk of a dataset
+ * 
+ * Returned by QH5Dataset::chunkInfo() and QH5Dataset::chunks().
+ */
+struct HDF_EXPORT QH5ChunkInfo
+{
+    QVector<quint64> offset;    //!< logical position of the chunk's first element in the dataset
+    quint32 filterMask;         //!< bit i set = filter i of the pipeline was skipped for this chunk
+    quint64 address;            //!< address of the chunk in the file
+    quint64 size;               //!< stored (compressed) size in bytes
+
+    QH5ChunkInfo() : filterMask(0), address(0), size(0) {}
+};
+
+/**
+ * @brief Options for opening HDF5 datasets
+ * 
+ * Collects the settings of a HDF5 dataset access property list.
+ * These are passed to QH5Group::openDataset() and apply only to the opened dataset object. 
+ * 
+ * Currently only the chunk cache is configurable.
+ * 
+ */
+class HDF_EXPORT QH5DatasetAccessOptions
+{
+    friend class QH5Group;
+public:
+    /**
+     * @brief Default constructor. Corresponds to H5P_DEFAULT. 
+     */
+    QH5DatasetAccessOptions() {}
+
+    /**
+     * @brief Set the chunk cache of the dataset (H5Pset_chunk_cache)
+     */
+    void setChunkCache(const QH5ChunkCache& c) { cache_ = c; }
+    /**
+     * @brief Return the chunk cache settings
+     */
+    const QH5ChunkCache& chunkCache() const { return cache_; }
+
+private:
+    QH5ChunkCache cache_;
+
+    /*
+     * Create a HDF5 dataset access property list.
+     * Returns an invalid object if the defaults are adequate.
+     */
+    QH5id createPlist() const;
+};
+
+/**
+ * @brief A wrapper for HDF5 datasets
+ * 
+ */
+class HDF_EXPORT QH5Dataset : public QH5Node
+{
+    friend class QH5id;
+    friend class QH5Group;
+    friend class QH5File;
+    friend class QH5StreamWriter;
+    QH5Dataset(h5id id, bool incref) : QH5Node(id,incref,KIND_DATASET) {}
+
+public:
+    /**
+     * @brief Default constructor
+     * 
+     * Creates an invalid QH5Dataset object
+     * 
+     */
+    QH5Dataset() : QH5Node() {}
+
+    QH5Dataset(const QH5Dataset& o) = default;
+    QH5Dataset(QH5Dataset&& o) = default;
+
+    QH5Dataset& operator=(const QH5Dataset& o)
+    { *((QH5id*)this) = o; return *this; }
+    QH5Dataset& operator=(QH5Dataset&& o)
+    { *((QH5id*)this) = std::move(o); return *this; }
+
+    /**
+     * @brief Return the associated datatype
+     */
+    QH5Datatype datatype() const;
+
+    /**
+     * @brief Return the associated dataspace
+     */
+    QH5Dataspace dataspace() const;
+
+    /**
+     * @brief Return the creation options of this dataset
+     * 
+     * Reads back the layout, filters and allocation time from the dataset
+     * creation property list. The fill value is not retrieved.
+     */
+    QH5DatasetCreateOptions createOptions() const;
+
+    /**
+     * @brief Return the current chunk cache settings of this dataset 
+     * 
+     * Calls H5Pget_chunk_cache on the dataset access property list.
+     */
+    QH5ChunkCache chunkCache() const;
+
+    /**
+     * @brief Change the dimensions of the dataset
+     * 
+     * Calls H5Dset_extent. The dataset must be chunked and dims must
+     * not exceed the maximum dimensions of its dataspace.
+     * 
+     * @return true If succesfull
+     * @return false If this object is invalid or the rank of dims is wrong
+     */
+    bool setExtent(const QVector<quint64>& dims) const;
+
+    /**
+     * @brief Append data to this dataset
+     * 
+     * The dataset is extended along the first dimension and data is written to 
+     * the new slab. For a N-D dataset the number of elements in data must be a 
+     * multiple of the size of a record, i.e., of the product of dimensions 2..N. 
+     * 
+     * The dataset must have been created with an extendible first dimension.
+     * 
+     * Each call changes the extent of the dataset once. When many small records
+     * are appended use QH5Appender, which collects them in larger blocks.
+     * 
+     * @tparam T Type of the data
+     * @param data data to append
+     * @return true if data was written, false otherwise
+     */
+    template<typename T>
+    bool append(const T& data) const
+    {
+        return append_(QH5Datatype::traits<T>::cptr(data),
+                       QH5Datatype::traits<T>::dataspace(data).selectionSize(),
+                       QH5Datatype::fromValue(data));
+    }
+
+    /**
+     * @brief Append n elements to this dataset
+     * 
+     * See append(const T&) for details.
+     * 
+     * @tparam T Type of the data
+     * @param data Pointer to an array of n elements
+     * @param n Number of elements
+     * @return true if data was written, false otherwise
+     */
+    template<typename T>
+    bool append(const T* data, quint64 n) const
+    {
+        if (!n) return true;
+        return data ? append_(data, n, QH5Datatype::fromValue(*data)) : false;
+    }
+
+    /**
+     * @brief Write a raw chunk, bypassing the filter pipeline
+     * 
+     * Calls H5Dwrite_chunk. data must contain the chunk as it will be stored in 
+     * the file, i.e., already processed by the filters of the dataset 
+     * (e.g. shuffled and deflate-compressed). 
+     * 
+     * The dataset must be chunked and offset must be a multiple of the chunk dimensions 
+     * within the current extent.
+     * 
+     * Requires HDF5 >= 1.10.5.
+     * 
+     * @param offset Logical position of the first element of the chunk
+     * @param filterMask Filters that were skipped for this chunk (bit i = filter i), 0 if all applied
+     * @param data Raw chunk data
+     * @return true If succesfull
+     * @return false If this object is invalid, the rank of offset is wrong or HDF5 is too old
+     */
+    bool writeChunk(const QVector<quint64>& offset, quint32 filterMask,
+                    const QByteArray& data) const;
+
+    /**
+     * @brief Read a raw chunk, bypassing the filter pipeline
+     * 
+     * Calls H5Dread_chunk. The chunk is returned as stored in the file, 
+     * e.g., compressed.
+     * 
+     * Requires HDF5 >= 1.10.5.
+     * 
+     * @param offset Logical position of the first element of the chunk
+     * @param filterMask If not null receives the filter mask of the chunk
+     * @return QByteArray The raw chunk or an empty array if the chunk is not allocated
+     */
+    QByteArray readChunk(const QVector<quint64>& offset, quint32* filterMask = 0) const;
+
+    /**
+     * @brief Return the number of allocated chunks
+     * 
+     * Calls H5Dget_num_chunks. Requires HDF5 >= 1.10.5.
+     */
+    quint64 chunkCount() const;
+
+    /**
+     * @brief Get the storage information of the chunk at a given position 
+     * 
+     * Calls H5Dget_chunk_info_by_coord. Requires HDF5 >= 1.10.5.
+     * 
+     * @param offset Logical position of the first element of the chunk
+     * @param info Receives the chunk information
+     * @return true If the chunk is allocated
+     * @return false Otherwise
+     */
+    bool chunkInfo(const QVector<quint64>& offset, QH5ChunkInfo& info) const;
+
+    /**
+     * @brief Return the storage information of all allocated chunks
+     * 
+     * The chunks are listed in row-major order of their position.
+     * 
+     * Requires HDF5 >= 1.10.5.
+     */
+    QVector<QH5ChunkInfo> chunks() const;
+
+    /**
+     * @brief Copy all chunks of another dataset byte-for-byte
+     * 
+     * The raw chunks of src are read with readChunk() and written to this
+     * dataset with writeChunk(), so no decompression/compression takes place.
+     * 
+     * Both datasets must have the same datatype, chunk dimensions and filters. 
+     * If a dimension of this dataset is smaller than that of src, it is first
+     * extended. The dataset is never shrunk.
+     * 
+     * @param src The source dataset
+     * @return true If succesfull
+     * @return false If the datasets are not compatible or HDF5 is too old
+     */
+    bool copyChunksFrom(const QH5Dataset& src) const;
+
+    /**
+     * @brief Refresh the dataset metadata from the file
+     * 
+     * Calls H5Drefresh. Used by readers of a file open in SWMR read mode in order 
+     * to see the current extent of a dataset that is being written by 
+     * another process. 
+     * 
+     * @return true If succesfull
+     * @return false If this object is invalid
+     */
+    bool refresh() const;
+
+    /**
+     * @brief Flush the dataset buffers to disk
+     * 
+     * Calls H5Dflush. Used by a SWMR writer to make appended data
+     * visible to readers.
+     * 
+     * @return true If succesfull
+     * @return false If this object is invalid
+     */
+    bool flush() const;
+
+    /**
+     * @brief Return the storage size of the dataset in bytes
+     * 
+     * Calls H5Dget_storage_size. This is the amount of space actually allocated
+     * in the file for raw data, i.e., after compression.
+     * 
+     * Comparing with dataspace().size() * datatype().size() gives the compression ratio.
+     */
+    quint64 storageSize() const;
+
+    /**
+     * @brief Write data to this dataset
+     * 
+     * Datatype and dataspace are inferred from data. 
+     * 
+     * @tparam T Type of the data
+     * @param data data to write
+     * @return true if data was written, false otherwise
+     */
+    template<typename T>
+    bool write(const T& data) const
+    {
+        QH5Datatype datatype = QH5Datatype::fromValue(data);
+        return write_(QH5Datatype::traits<T>::cptr(data),
+                      QH5Datatype::traits<T>::dataspace(data),
+                      datatype);
+    }
+
+    /**
+     * @brief Write data to this dataset
+     * 
+     * @tparam T Type of the data
+     * @param data data to write
+     * @param memspace memory dataspace
+     * @param memtype memory datatype
+     * @return true if data was written, false otherwise
      */
     template<typename T>
     bool write(const T& data, const QH5Dataspace& memspace,
@@ -582,6 +1649,60 @@ public:
         return write_(QH5Datatype::traits<T>::cptr(data),
                       memspace, memtype);
     }
+    /**
+     * @brief Write data to a selected region of this dataset
+     * 
+     * Datatype and memory dataspace are inferred from data. 
+     * 
+     * The number of elements in data must be equal to
+     * fileSelection.selectionSize().
+     * 
+     * @tparam T Type of the data
+     * @param data data to write
+     * @param fileSelection A dataspace of this dataset with the target region selected
+     * @return true if data was written, false otherwise
+     */
+    template<typename T>
+    bool write(const T& data, const QH5Dataspace& fileSelection) const
+    {
+        QH5Datatype datatype = QH5Datatype::fromValue(data);
+        return write_(QH5Datatype::traits<T>::cptr(data),
+                      QH5Datatype::traits<T>::dataspace(data),
+                      datatype, fileSelection);
+    }
+    /**
+     * @brief Write data to this dataset compressing chunks in parallel
+     * 
+     * The data is split in chunks, which are shuffled and deflate-compressed 
+     * on the threads of pool. The compressed chunks are written in order 
+     * from the calling thread with writeChunk(). At most 2 chunks per pool 
+     * thread are kept in memory. 
+     * 
+     * The result is identical to a normal write() and can be read by any HDF5 
+     * application.
+     * 
+     * The parallel path is used when the dataset is chunked, its filters are 
+     * deflate and optionally shuffle and the memory type of data is 
+     * the same as the dataset type. Otherwise the function falls back to write().
+     * 
+     * data must cover the whole dataset.
+     * 
+     * Do not call from a thread of pool, the function waits for the pool tasks.
+     * 
+     * @tparam T Type of the data
+     * @param data data to write
+     * @param pool The thread pool. If null, QThreadPool::globalInstance() is used.
+     * @return true if data was written, false otherwise
+     */
+    template<typename T>
+    bool writeParallel(const T& data, QThreadPool* pool = 0) const
+    {
+        QH5Datatype datatype = QH5Datatype::fromValue(data);
+        return writeParallel_(QH5Datatype::traits<T>::cptr(data),
+                              QH5Datatype::traits<T>::dataspace(data),
+                              datatype, pool);
+    }
+
     /**
      * @brief Read data from this dataset
      * 
@@ -596,24 +1717,168 @@ public:
     bool read(T& data) const
     {
         QH5Datatype datatype = QH5Datatype::fromValue(data);
-        QH5Dataspace ds = dataspace();
-        QH5Datatype::traits<T>::resize(data,ds.size());
-        return read_(QH5Datatype::traits<T>::ptr(data),ds, datatype);
+        if (!resizeFor_(data, dataspace().selectionSize())) return false;
+        return read_(QH5Datatype::traits<T>::ptr(data),
+                     QH5Datatype::traits<T>::dataspace(data), datatype);
+    }
+
+    /**
+     * @brief Read data into a caller-provided buffer
+     * 
+     * The elements are stored in row-major order directly in dst. 
+     * No allocation or initialization of the output takes place.
+     * 
+     * @tparam T Type of the elements
+     * @param dst Pointer to a buffer of n elements
+     * @param n Number of elements in dst
+     * @param fileSelection A dataspace of this dataset with the region to read selected. 
+     * If invalid the whole dataset is read.
+     * @return true if data was read
+     * @return false if dst is too small or another error occurred
+     */
+    template<typename T>
+    bool read(T* dst, size_t n, const QH5Dataspace& fileSelection = QH5Dataspace()) const
+    {
+        if (!dst) return false;
+        quint64 m = !fileSelection.isNull() ? fileSelection.selectionSize() :
+                                              dataspace().selectionSize();
+        if (m > n) return false;
+        if (!m) return true;
+        return read_(dst, QH5Dataspace(QVector<quint64>(1,m)),
+                     QH5Datatype::fromValue(*dst), fileSelection);
+    }
+
+    /**
+     * @brief Write data from a caller-provided buffer
+     * 
+     * @tparam T Type of the elements
+     * @param src Pointer to n elements in row-major order
+     * @param n Number of elements
+     * @param fileSelection A dataspace of this dataset with the target region selected. 
+     * If invalid the whole dataset is written.
+     * @return true if data was written
+     * @return false if n does not match the dataset/selection size or another error occurred
+     */
+    template<typename T>
+    bool write(const T* src, size_t n, const QH5Dataspace& fileSelection = QH5Dataspace()) const
+    {
+        if (!src) return false;
+        quint64 m = !fileSelection.isNull() ? fileSelection.selectionSize() :
+                                              dataspace().selectionSize();
+        if (m != n) return false;
+        if (!m) return true;
+        return write_(src, QH5Dataspace(QVector<quint64>(1,m)),
+                      QH5Datatype::fromValue(*src), fileSelection);
+    }
+
+    /**
+     * @brief Read a selected region of this dataset
+     * 
+     * The HDF5 datatype is inferred from type of data.
+     * 
+     * Only the elements selected in fileSelection are read. Container types
+     * are resized to fileSelection.selectionSize() and the elements
+     * are stored in row-major order.
+     * 
+     * @tparam T Type of the data
+     * @param data data to read
+     * @param fileSelection A dataspace of this dataset with the region to read selected
+     * @return true if data was read
+     * @return false if the selection does not fit in data, e.g., more than INT_MAX elements 
+     * or a std::array of a different size, or another error occurred
+     */
+    template<typename T>
+    bool read(T& data, const QH5Dataspace& fileSelection) const
+    {
+        QH5Datatype datatype = QH5Datatype::fromValue(data);
+        if (!resizeFor_(data, fileSelection.selectionSize())) return false;
+        return read_(QH5Datatype::traits<T>::ptr(data),
+                     QH5Datatype::traits<T>::dataspace(data),
+                     datatype, fileSelection);
+    }
+
+    /**
+     * @brief Read data from this dataset decompressing chunks in parallel
+     * 
+     * The raw chunks are read from the calling thread with readChunk(),
+     * decompressed on the threads of pool and copied directly into data.
+     * At most 2 chunks per pool thread are kept in memory.
+     * 
+     * The parallel path is used when the dataset is chunked, its filters are 
+     * deflate and/or shuffle and the memory type of data is 
+     * the same as the dataset type. Otherwise the function falls back to read().
+     * 
+     * Do not call from a thread of pool, the function waits for the pool tasks.
+     * 
+     * @tparam T Type of the data
+     * @param data data to read
+     * @param pool The thread pool. If null, QThreadPool::globalInstance() is used.
+     * @return true if data was read, false otherwise
+     */
+    template<typename T>
+    bool readParallel(T& data, QThreadPool* pool = 0) const
+    {
+        return readParallel(data, dataspace(), pool);
+    }
+
+    /**
+     * @brief Read a selected region decompressing chunks in parallel
+     * 
+     * As readParallel(T&, QThreadPool*) for the elements selected in fileSelection.
+     * 
+     * The parallel path requires that the selection is a single block, 
+     * e.g., a hyperslab without stride. Other selections are read with read().
+     * 
+     * @tparam T Type of the data
+     * @param data data to read
+     * @param fileSelection A dataspace of this dataset with the region to read selected
+     * @param pool The thread pool. If null, QThreadPool::globalInstance() is used.
+     * @return true if data was read, false otherwise
+     */
+    template<typename T>
+    bool readParallel(T& data, const QH5Dataspace& fileSelection,
+                      QThreadPool* pool = 0) const
+    {
+        QH5Datatype datatype = QH5Datatype::fromValue(data);
+        if (!resizeFor_(data, fileSelection.selectionSize())) return false;
+        return readParallel_(QH5Datatype::traits<T>::ptr(data),
+                             QH5Datatype::traits<T>::dataspace(data),
+                             datatype, fileSelection, pool);
     }
 
 private:
+    // resize a container to n elements, false if data cannot hold them
+    template<typename T>
+    static bool resizeFor_(T& data, quint64 n)
+    {
+        if (n > quint64(INT_MAX)) return false;
+        QH5Datatype::traits<T>::resize(data, int(n));
+        return QH5Datatype::traits<T>::dataspace(data).selectionSize() == n;
+    }
+
     bool write_(const void* data, const QH5Dataspace& memspace,
-               const QH5Datatype& memtype) const;
+               const QH5Datatype& memtype,
+               const QH5Dataspace& filespace = QH5Dataspace()) const;
     bool write_(const QString& str) const;
     bool write_(const QString& str, const QH5Dataspace& memspace,
                 const QH5Datatype& memtype) const;
-    bool write_(const QStringList& str) const;
+    bool write_(const QStringList& str,
+                const QH5Dataspace& filespace = QH5Dataspace()) const;
     bool write_(const QStringList& str, const QH5Dataspace& memspace,
-                const QH5Datatype& memtype) const;
+                const QH5Datatype& memtype,
+                const QH5Dataspace& filespace = QH5Dataspace()) const;
     bool read_(void* data, const QH5Dataspace& memspace,
-              const QH5Datatype& memtype) const;
+              const QH5Datatype& memtype,
+              const QH5Dataspace& filespace = QH5Dataspace()) const;
     bool read_(QString& str) const;
-    bool read_(QStringList& str) const;
+    bool read_(QStringList& str,
+               const QH5Dataspace& filespace = QH5Dataspace()) const;
+    bool append_(const void* data, quint64 n, const QH5Datatype& memtype) const;
+    bool writeParallel_(const void* data, const QH5Dataspace& memspace,
+                        const QH5Datatype& memtype, QThreadPool* pool) const;
+    bool readParallel_(void* data, const QH5Dataspace& memspace,
+                       const QH5Datatype& memtype, const QH5Dataspace& filespace,
+                       QThreadPool* pool) const;
 };
 
 // template specializations of read/write functions
@@ -628,6 +1893,12 @@ inline bool QH5Dataset::read<QStringList>(QStringList& data) const
     return read_(data);
 };
 template<>
+inline bool QH5Dataset::read<QStringList>(QStringList& data,
+                                          const QH5Dataspace& fileSelection) const
+{
+    return read_(data, fileSelection);
+};
+template<>
 inline bool QH5Dataset::write<QString>(const QString& data) const
 {
     return write_(data);
@@ -644,12 +1915,220 @@ inline bool QH5Dataset::write<QStringList>(const QStringList& data) const
     return write_(data);
 };
 template<>
+inline bool QH5Dataset::write<QStringList>(const QStringList& data,
+                                           const QH5Dataspace& fileSelection) const
+{
+    return write_(data, fileSelection);
+};
+template<>
 inline bool QH5Dataset::write<QStringList>(const QStringList& data, const QH5Dataspace& memspace,
                                            const QH5Datatype& memtype) const
 {
     return write_(data, memspace, memtype);
 };
 
+/**
+ * @brief Buffered appending of records to an extendible dataset
+ * 
+ * QH5Appender collects appended elements in memory and writes them
+ * to the dataset in blocks. Thus, the extent of the dataset changes once per 
+ * block instead of once per call to append().
+ * 
+ * The block size defaults to the chunk size along the first dimension
+ * of the dataset, so that every write fills whole chunks.
+ * 
+ * Buffered data is written when the buffer is full, when flush() is called 
+ * and when the appender is destroyed.
+ * 
+ * \code
+ * QH5Dataset ds = root.createDataset("adc",
+ *                   QH5Dataspace::extendible({0}),
+ *                   QH5Datatype::fromValue(qint16()));
+ * QH5Appender<qint16> app(ds);
+ * while (acquiring) app.append(sample());
+ * app.flush();
+ * \endcode
+ * 
+ * @tparam T Type of the elements
+ */
+template<typename T>
+class QH5Appender
+{
+    QH5Dataset ds_;
+    QVector<T> buffer_;
+    int n_;
+public:
+    /**
+     * @brief Construct a new QH5Appender object
+     * 
+     * @param ds An extendible dataset
+     * @param blockSize Number of elements per write. If 0 the size of a chunk 
+     * is used.
+     */
+    explicit QH5Appender(const QH5Dataset& ds, int blockSize = 0) : ds_(ds), n_(0)
+    {
+        if (blockSize <= 0) {
+            // whole chunks along the first dimension x record size
+            QVector<quint64> chunk = ds_.createOptions().chunk();
+            QVector<quint64> dims = ds_.dataspace().dimensions();
+            blockSize = chunk.isEmpty() ? 1 : chunk[0];
+            for(int i=1; i<dims.size(); ++i) blockSize *= dims[i];
+            if (blockSize < 1) blockSize = 1;
+            if (blockSize < 1024) blockSize *= (1024 + blockSize - 1) / blockSize;
+        }
+        buffer_.resize(blockSize);
+    }
+    /**
+     * @brief Destroy the QH5Appender object, writing any buffered data
+     */
+    ~QH5Appender()
+    {
+        try { flush(); }
+        catch (const std::exception&) {}
+    }
+    /**
+     * @brief Append one element
+     * 
+     * @return false If a write failed. The element is buffered nevertheless 
+     * if there is room for it.
+     */
+    bool append(const T& v)
+    {
+        // full after a failed write
+        if (n_ == buffer_.size() && !flush()) return false;
+        buffer_[n_++] = v;
+        return n_ < buffer_.size() ? true : flush();
+    }
+    /**
+     * @brief Append n elements
+     * 
+     * @return false If a write failed. Elements that did not fit in the 
+     * buffer are then not appended.
+     */
+    bool append(const T* v, quint64 n)
+    {
+        while (n) {
+            quint64 m = qMin(n, quint64(buffer_.size() - n_));
+            std::copy(v, v + m, buffer_.data() + n_);
+            n_ += m; v += m; n -= m;
+            if (n_ == buffer_.size() && !flush()) return false;
+        }
+        return true;
+    }
+    /**
+     * @brief Write buffered elements to the dataset
+     * 
+     * If the write fails the elements stay buffered and are written
+     * by the next flush().
+     */
+    bool flush()
+    {
+        if (!n_) return true;
+        if (!ds_.append(buffer_.constData(), n_)) return false;
+        n_ = 0;
+        return true;
+    }
+    /**
+     * @brief Return the number of buffered elements
+     */
+    int pending() const { return n_; }
+    /**
+     * @brief Return the dataset
+     */
+    const QH5Dataset& dataset() const { return ds_; }
+};
+
+/**
+ * @brief A member of a HDF5 group
+ * 
+ * Reported by QH5Group::iterate() and QH5Group::entries().
+ */
+struct HDF_EXPORT QH5GroupEntry
+{
+    QByteArray name;    //!< link name
+    QH5Node::Type type; //!< type of the linked object
+
+    QH5GroupEntry() : type(QH5Node::UNKNOWN) {}
+};
+
+/**
+ * @brief An object found by QH5Group::visit()
+ */
+struct HDF_EXPORT QH5VisitEntry
+{
+    QByteArray path;    //!< path relative to the visited group
+    QH5Node::Type type; //!< object type
+    quint64 address;    //!< object address in the file, unique within the file
+    int depth;          //!< 1 for direct members of the visited group, 2 for their members etc
+    qint64 ctime;       //!< object header change time in s since the epoch, 0 if not tracked
+    /**
+     * @brief Dataset dimensions
+     * 
+     * Set only for datasets and if QH5VisitFilter::details is true.
+     */
+    QVector<quint64> shape;
+    /**
+     * @brief Dataset datatype class
+     * 
+     * Set only for datasets and if QH5VisitFilter::details is true.
+     */
+    QH5Datatype::Class dtypeClass;
+
+    QH5VisitEntry() : type(QH5Node::UNKNOWN), address(0), depth(0), ctime(0),
+        dtypeClass(QH5Datatype::UNSUPPORTED) {}
+};
+
+/**
+ * @brief Filter for QH5Group::visit()
+ * 
+ * The default filter accepts all objects.
+ * 
+ * \code
+ * QH5VisitFilter filter;
+ * filter.prefix = "run42/ch";
+ * filter.types = QH5VisitFilter::typeBit(QH5Node::DATASET);
+ * filter.maxDepth = 3;
+ * \endcode
+ */
+struct HDF_EXPORT QH5VisitFilter
+{
+    /**
+     * @brief Report only objects whose path starts with prefix
+     * 
+     * The traversal starts at the group named by the prefix up to its last '/',
+     * so that the rest of the file is not visited. Leading '/' are ignored,
+     * the prefix is relative to the visited group.
+     */
+    QByteArray prefix;
+    /**
+     * @brief Bit mask of accepted QH5Node::Type values, see typeBit()
+     */
+    unsigned types;
+    /**
+     * @brief Report only objects up to this depth, -1 for unlimited
+     * 
+     * If only members of the start group can be reported, e.g., maxDepth = 1
+     * without a '/' in prefix, the members of that group are listed without
+     * descending further. Otherwise the whole subtree of the start group is
+     * traversed and deeper objects are only filtered out.
+     */
+    int maxDepth;
+    /**
+     * @brief Also report shape and datatype class of datasets
+     * 
+     * This requires opening each reported dataset and is much slower 
+     * than the plain traversal.
+     */
+    bool details;
+
+    QH5VisitFilter() : types(~0u), maxDepth(-1), details(false) {}
+
+    /**
+     * @brief Bit corresponding to type t in the types mask
+     */
+    static unsigned typeBit(QH5Node::Type t) { return 1u << t; }
+};
+
 /**
  * @brief A wrapper for HDF5 groups
  * 
@@ -658,7 +2137,7 @@ class HDF_EXPORT QH5Group : public QH5Node
 {
     friend class QH5id;
     friend class QH5File;
-    QH5Group(h5id id, bool incref) : QH5Node(id,incref) {}
+    QH5Group(h5id id, bool incref) : QH5Node(id,incref,KIND_GROUP) {}
 public:
     /**
      * @brief Default constructor
@@ -733,17 +2212,30 @@ public:
      */
     bool isCreationOrderIdx() const;
 
+    /**
+     * @brief Number of links in a group
+     * 
+     * The count is read from the group's link info with H5Gget_info_by_name, 
+     * without opening the group or iterating over its members.
+     * 
+     * @param name Path of the group relative to this group, "." for this group
+     * @return quint64 The number of links, 0 if this object is invalid
+     */
+    quint64 linkCount(const char* name = ".") const;
+
     /**
      * @brief Create a dataset object
      * 
      * @param name The name of the dataset
      * @param dataspace The dataspace of the new dataset
      * @param datatype The datatype of the new dataset
+     * @param options Layout, filters and other creation options
      * @return QH5Dataset The dataset object. Invalid if the operation failed.
      */
     QH5Dataset createDataset(const char *name,
                              const QH5Dataspace& dataspace,
-                             const QH5Datatype& datatype) const;
+                             const QH5Datatype& datatype,
+                             const QH5DatasetCreateOptions& options = QH5DatasetCreateOptions()) const;
 
     /**
      * @brief Open a dataset
@@ -751,9 +2243,11 @@ public:
      * The function checks if the name exists and if it is a dataset. Then it opens the dataset. 
      * 
      * @param name The name of the dataset
+     * @param options Access options, e.g., the chunk cache configuration
      * @return QH5Dataset The dataset object. Invalid if the operation failed.
      */
-    QH5Dataset openDataset(const char *name) const;
+    QH5Dataset openDataset(const char *name,
+                           const QH5DatasetAccessOptions& options = QH5DatasetAccessOptions()) const;
 
     /**
      * @brief Write data to a dataset
@@ -766,15 +2260,17 @@ public:
      * @tparam T Type of the data to write
      * @param name Name of the dataset
      * @param data The data to write
+     * @param options Creation options, used only if a new dataset is created
      * @return true If succesfull, false otherwise
      */
     template<typename T>
-    bool write(const char *name, const T& data) const
+    bool write(const char *name, const T& data,
+               const QH5DatasetCreateOptions& options = QH5DatasetCreateOptions()) const
     {
         QH5Dataset ds;
         if (exists(name) && isDataset(name)) ds = openDataset(name);
         else ds = createDataset(name, QH5Datatype::traits<T>::dataspace(data),
-                                      QH5Datatype::fromValue(data));
+                                      QH5Datatype::fromValue(data), options);
         return ds.isValid() ? ds.write(data) : false;
     }
 
@@ -828,8 +2324,82 @@ public:
      */
     QByteArrayList datasetNames() const;
 
-private:
-    QByteArray objname_by_idx(int i, bool idxCreationOrder) const;
+    /**
+     * @brief Visit all members of this group
+     * 
+     * The links of the group are traversed once with H5Literate and f is 
+     * called with the name and object type of each member.
+     * Iteration stops when f returns false.
+     * 
+     * \code
+     * g.iterate([](const QH5GroupEntry& e) {
+     *     if (e.type == QH5Node::DATASET) qDebug() << e.name;
+     *     return true;
+     * });
+     * \endcode
+     * 
+     * A long listing can be split in slices by passing a position: iteration
+     * starts at member *position and on return *position is the index of the
+     * member following the last one passed to f. Calling iterate() again with
+     * the same position resumes the listing, as long as the group is not modified
+     * in between. Between slices other threads may call the HDF5 library,
+     * which with a thread-safe build is locked for the whole H5Literate call.
+     * 
+     * @param f Callback function
+     * @param idxCreationOrder If true and the group was created with creation order enabled then 
+     *      the members are visited in creation order, otherwise in name order 
+     * @param position If not null, the index of the first member to visit, 
+     *      updated to the index where iteration can be resumed
+     * @return true If all members were visited
+     * @return false If f returned false or this object is invalid
+     */
+    bool iterate(const std::function<bool(const QH5GroupEntry&)>& f,
+                 bool idxCreationOrder = false, quint64* position = 0) const;
+
+    /**
+     * @brief Get the names and object types of all members of this group
+     * 
+     * @param idxCreationOrder If true and the group was created with creation order enabled then 
+     *      the members are ordered according to creation time 
+     * @return QVector<QH5GroupEntry> The group members
+     */
+    QVector<QH5GroupEntry> entries(bool idxCreationOrder = false) const;
+
+    /**
+     * @brief Recursively visit all objects below this group
+     * 
+     * The hierarchy is traversed in a single call to H5Ovisit, 
+     * which reads the object headers without opening a handle for each object.
+     * Each object is reported once, even if it is reachable by more than 
+     * one path. Soft and external links are not followed.
+     * 
+     * Objects are visited in name order, parents before their members. 
+     * The traversal stops when f returns false.
+     * 
+     * \code
+     * QH5VisitFilter filter;
+     * filter.types = QH5VisitFilter::typeBit(QH5Node::DATASET);
+     * h5f.root().visit([](const QH5VisitEntry& e) {
+     *     qDebug() << e.path << e.address;
+     *     return true;
+     * }, filter);
+     * \endcode
+     * 
+     * @param f Callback function
+     * @param filter Selects the objects passed to f
+     * @return true If the traversal was completed
+     * @return false If f returned false or this object is invalid
+     */
+    bool visit(const std::function<bool(const QH5VisitEntry&)>& f,
+               const QH5VisitFilter& filter = QH5VisitFilter()) const;
+
+    /**
+     * @brief Get all objects below this group accepted by filter
+     * 
+     * @param filter Selects the objects returned
+     * @return QVector<QH5VisitEntry> The objects, in the order visited
+     */
+    QVector<QH5VisitEntry> objects(const QH5VisitFilter& filter = QH5VisitFilter()) const;
 
 };
 
@@ -837,6 +2407,8 @@ private:
  * @brief A wrapper class for HDF5 files 
  * 
  */
+struct QH5HandleCache;
+
 class HDF_EXPORT QH5File
 {
     friend class QH5id;
@@ -844,13 +2416,21 @@ class HDF_EXPORT QH5File
     QString fname_;
     QString error_msg_;
     QH5id id_;
+    bool core_;
+    size_t coreIncrement_;
+    bool coreBackingStore_;
+    QH5ChunkCache chunkCache_;
+    int handleCacheSize_;
+    QSharedPointer<QH5HandleCache> handles_;
 public:
     /**
      * @brief Construct a new QH5File object
      * 
      * @param fname The name of the HDF5 file
      */
-    QH5File (const QString& fname = QString()) : fname_(fname) {}
+    QH5File (const QString& fname = QString()) : fname_(fname),
+        core_(false), coreIncrement_(1<<20), coreBackingStore_(false),
+        handleCacheSize_(64) {}
 
     /**
      * @brief Open the HDF5 file
@@ -862,16 +2442,57 @@ public:
      * 
      * An existing HDF5 file can be opened either with QIODevice::ReadWrite or with QIODevice::ReadOnly.
      * 
+     * If swmr is true the file is opened for single-writer/multiple-reader (SWMR) access
+     * and the latest HDF5 file format is used:
+     *      - QIODevice::ReadOnly : SWMR read mode (H5F_ACC_SWMR_READ). The file can be read
+     *        while another process writes to it. Use QH5Dataset::refresh() to see new data.
+     *      - QIODevice::ReadWrite : SWMR write mode (H5F_ACC_SWMR_WRITE) for an existing file.
+     *      - new or truncated file : the file is created with the latest format. Create 
+     *        all groups and datasets and then call startSwmrWrite().
+     * 
+     * In SWMR write mode only existing datasets can be written to and extended; no
+     * new objects can be created.
+     * 
      * @param mode A combination of QIODevice flags
+     * @param swmr Open in SWMR mode
      * @return true If the file has been succesfully opened or created
      * @return false File does not exist or could not be created
      */
-    bool open(QIODevice::OpenMode mode = QIODevice::ReadWrite);
+    bool open(QIODevice::OpenMode mode = QIODevice::ReadWrite, bool swmr = false);
+
+    /**
+     * @brief Switch a newly created file to SWMR write mode
+     * 
+     * Calls H5Fstart_swmr_write. The file must have been opened with swmr = true.
+     * After this call readers can open the file with SWMR read access.
+     * 
+     * @return true If succesfull
+     * @return false If the file is not open
+     */
+    bool startSwmrWrite();
+
+    /**
+     * @brief Returns true if the file is open in SWMR read or write mode
+     */
+    bool isSwmr() const;
+
+    /**
+     * @brief Flush all buffers of the file to disk
+     * 
+     * Calls H5Fflush. In SWMR write mode this makes written data visible to readers.
+     * 
+     * @return true If succesfull
+     * @return false If the file is not open
+     */
+    bool flush() const;
 
     /**
      * @brief Close the HDF5 file. Returns true if succesfull. 
+     * 
+     * The handles held by the open-handle cache are released before closing,
+     * see group() and dataset().
      */
-    bool close() { return id_.close(); }
+    bool close();
 
     /**
      * @brief Returns true if the file is open
@@ -888,6 +2509,113 @@ public:
         if (!isOpen()) fname_ = fname;
     }
 
+    /**
+     * @brief Return the filename of this object
+     */
+    const QString& fileName() const { return fname_; }
+
+    /**
+     * @brief Return a description of the last error that occurred in open()
+     */
+    const QString& errorString() const { return error_msg_; }
+
+    /**
+     * @brief Keep the file in memory
+     * 
+     * If on is true the file is opened with the HDF5 core driver (H5Pset_fapl_core).
+     * The whole file resides in memory and no disk I/O takes place while it is open.
+     * 
+     * If backingStore is false, a new file exists only in memory and is discarded when
+     * closed. An existing disk file is read into memory and changes are not saved.
+     * 
+     * If backingStore is true the contents are written to the disk file when it is closed.
+     * 
+     * The setting is ignored if the file is already open.
+     * 
+     * @param on Enable the core driver
+     * @param increment Memory is allocated in steps of increment bytes
+     * @param backingStore Write the file to disk when it is closed
+     */
+    void setInMemory(bool on, size_t increment = 1<<20, bool backingStore = false)
+    {
+        if (isOpen()) return;
+        core_ = on;
+        coreIncrement_ = increment ? increment : 1<<20;
+        coreBackingStore_ = backingStore;
+    }
+
+    /**
+     * @brief Returns true if the file is kept in memory
+     */
+    bool isInMemory() const { return core_; }
+
+    /**
+     * @brief Set the default chunk cache for all datasets of the file
+     * 
+     * Calls H5Pset_cache on the file access property list. Individual datasets can
+     * override this setting with QH5DatasetAccessOptions.
+     * 
+     * The setting is ignored if the file is already open.
+     */
+    void setChunkCache(const QH5ChunkCache& c)
+    {
+        if (!isOpen()) chunkCache_ = c;
+    }
+
+    /**
+     * @brief Return the default chunk cache settings of the open file
+     * 
+     * Calls H5Pget_cache on the file access property list. If the file is not open
+     * the value set by setChunkCache() is returned.
+     */
+    QH5ChunkCache chunkCache() const;
+
+    /**
+     * @brief Runtime statistics of the HDF5 caches of an open file
+     * 
+     * HDF5 does not report hit rates for the raw data chunk caches. The statistics
+     * refer to the metadata cache, which holds object headers and chunk indices
+     * (B-trees) and thus reflects the cost of locating chunks.
+     */
+    struct CacheStatistics {
+        double metadataHitRate;     //!< hit rate of the metadata cache since the last reset (H5Fget_mdc_hit_rate)
+        size_t metadataMaxSize;     //!< maximum size of the metadata cache in bytes
+        size_t metadataCurrentSize; //!< current size of the metadata cache in bytes
+        int metadataEntries;        //!< number of entries in the metadata cache
+    };
+
+    /**
+     * @brief Return cache statistics for the open file
+     * 
+     * Calls H5Fget_mdc_hit_rate and H5Fget_mdc_size. 
+     * 
+     * @param reset Reset the hit rate statistics after reading them
+     */
+    CacheStatistics cacheStatistics(bool reset = false) const;
+
+    /**
+     * @brief Return an image of the file in memory
+     * 
+     * The file is flushed and H5Fget_file_image is called to obtain 
+     * the file contents. The image is a valid HDF5 file that can be 
+     * saved to disk or opened with fromImage().
+     * 
+     * @return QByteArray The file image or an empty array if the file is not open
+     */
+    QByteArray toImage() const;
+
+    /**
+     * @brief Open a HDF5 file from an image in memory
+     * 
+     * A copy of image is opened with the core driver (H5Pset_file_image), so that no
+     * disk I/O takes place. Changes are kept in memory and can be retrieved with toImage().
+     * 
+     * @param image The contents of a HDF5 file
+     * @param writable If true the file is opened with read/write access
+     * @return QH5File The open file. isOpen() returns false if the image could not be opened.
+     */
+    static QH5File fromImage(const QByteArray& image, bool writable = false);
+
     /**
      * @brief Return the root group of the file
      * 
@@ -897,13 +2625,84 @@ public:
      */
     QH5Group root() const;
 
+    /**
+     * @brief Open a group by its full path
+     * 
+     * The path is relative to the root group, a leading '/' is optional.
+     * The object is opened with a single H5Oopen call, without the existence and 
+     * type checks of QH5Group::openGroup().
+     * 
+     * The opened groups are kept in an LRU cache of open handles, keyed by path, 
+     * so that repeated lookups of the same path do not touch the file.
+     * 
+     * \code
+     * QH5File h5f("data.h5");
+     * h5f.open();
+     * h5f.group("run42/ch3", true).write("adc", v);
+     * ...
+     * QH5Dataset ds = h5f.dataset("run42/ch3/adc");
+     * \endcode
+     * 
+     * @param path Group path
+     * @param create If true, the group and any missing intermediate groups are created
+     * @return QH5Group The group. If it does not exist or the path does not name a group, 
+     *      an invalid object is returned.
+     */
+    QH5Group group(const QByteArray& path, bool create = false) const;
+
+    /**
+     * @brief Open a dataset by its full path
+     * 
+     * As group(), the dataset handle is kept in the open-handle cache.
+     * 
+     * @param path Dataset path, relative to the root group
+     * @return QH5Dataset The dataset. If it does not exist or the path does not name a dataset, 
+     *      an invalid object is returned.
+     */
+    QH5Dataset dataset(const QByteArray& path) const;
+
+    /**
+     * @brief Set the capacity of the open-handle cache
+     * 
+     * Must be called before open(). A size of 0 disables the cache.
+     * The default is 64 handles.
+     */
+    void setHandleCacheSize(int n)
+    {
+        if (!isOpen()) handleCacheSize_ = qMax(0, n);
+    }
+
+    /**
+     * @brief Capacity of the open-handle cache
+     */
+    int handleCacheSize() const { return handleCacheSize_; }
+
+    /**
+     * @brief Release all handles held by the open-handle cache
+     * 
+     * Call this after removing or renaming objects through other means, 
+     * so that group() and dataset() do not return stale handles.
+     */
+    void clearHandleCache() const;
+
     /**
      * @brief Check if the disk file fname is a valid HDF5 file
      */
     static bool isHDF5(const QString& fname);
 
+    /**
+     * @brief Returns true if the HDF5 library was built thread-safe
+     * 
+     * Otherwise the library, and thus all QtHDF5 objects, must not be used 
+     * from more than one thread at a time.
+     */
+    static bool isThreadSafe();
+
 private:
     void pushError(const QString& err) { error_msg_ = err; }
+    QH5id accessPlist(bool swmr) const;
+    void openCached_(const QByteArray& path, bool createGroup,
+                     QH5Group& g, QH5Dataset& ds) const;
 
 };
 
@@ -2,10 +2,23 @@ INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
 SOURCES += \
-    $$PWD/qthdf5.cpp
+    $$PWD/qthdf5.cpp \
+    $$PWD/qh5streamwriter.cpp \
+    $$PWD/qh5parallel.cpp \
+    $$PWD/qh5datasetwatcher.cpp \
+    $$PWD/qh5fileindex.cpp \
+    $$PWD/qh5pyramid.cpp \
+    $$PWD/qh5chunkstats.cpp \
+    $$PWD/qh5reduce.cpp
 
 HEADERS +=  \
-    $$PWD/qthdf5.h
+    $$PWD/qthdf5.h \
+    $$PWD/qh5streamwriter.h \
+    $$PWD/qh5datasetwatcher.h \
+    $$PWD/qh5fileindex.h \
+    $$PWD/qh5pyramid.h \
+    $$PWD/qh5chunkstats.h \
+    $$PWD/qh5reduce.h
 
 
 unix {
@@ -14,8 +27,8 @@ unix {
 
     contains( UBUNTU, Ubuntu ) {
         CONFIG += link_pkgconfig
-        PKGCONFIG += hdf5-serial
+        PKGCONFIG += hdf5-serial zlib
     } else {
-        LIBS += -lhdf5
+        LIBS += -lhdf5 -lz
     }
 }